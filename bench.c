@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "config.h"
+#include "random.h"
+#include "system.h"
+
+// =======================================================
+//   Microbenchmarks of the core kernels
+// =======================================================
+//
+// N, PHI and RC are compile-time parameters (see run_bench.sh, which sweeps
+// them); the infected fraction is swept at runtime. Each result is printed as
+// one JSON object per line.
+
+// Steps timed per kernel and per infected fraction
+#ifndef BENCH_STEPS
+#define BENCH_STEPS 200
+#endif
+
+// Calls timed for the scalar primitives (RNG, minImage)
+#ifndef BENCH_CALLS
+#define BENCH_CALLS 10000000
+#endif
+
+// Sink preventing the compiler from removing benchmarked calls
+static volatile double sink;
+
+
+// Wall-clock time in nanoseconds
+static double nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+// Cell of particle idx (same rule as the propagation kernels)
+static int cellOf(systemSI *pS, int idx) {
+    int nCells = pS->nCells;
+    int ix = ((int)(pS->x[pS->d * idx + 0] / pS->cellSize)) % nCells;
+    int iy = ((int)(pS->x[pS->d * idx + 1] / pS->cellSize)) % nCells;
+    if (ix < 0) ix += nCells;
+    if (iy < 0) iy += nCells;
+    return iy * nCells + ix;
+}
+
+
+// Candidate pairs visited by one propagation step for the current states
+static double pairCandidates(systemSI *pS, int search) {
+    int z = pS->z;
+    double count = 0.0;
+
+    if (search == SEARCH_ALL) {
+        for (int idx = 0; idx < N; idx++) {
+            if (pS->state[idx] == 0) continue;
+            int c = cellOf(pS, idx);
+            for (int n = 0; n < z; n++)
+                count += pS->cellList[pS->neighborCell[z * c + n]].nParticles;
+        }
+    } else if (search == SEARCH_PAIRS) {
+        // Home cell pairs plus the forward half of the stencil
+        int zHome = (z - 1) / 2;
+        for (int c = 0; c < pS->nCells * pS->nCells; c++) {
+            double nHome = pS->cellList[c].nParticles;
+            count += nHome * (nHome - 1) / 2;
+            for (int n = zHome + 1; n < z; n++)
+                count += nHome * pS->cellList[pS->neighborCell[z * c + n]].nParticles;
+        }
+    } else if (search == SEARCH_IDX0 && pS->state[pS->idx0] == 0) {
+        int c = cellOf(pS, pS->idx0);
+        for (int n = 0; n < z; n++)
+            count += pS->cellList[pS->neighborCell[z * c + n]].nParticles;
+    }
+
+    return count;
+}
+
+
+// Infect a random fraction of particles (idx0 always infected)
+static void setInfectedFraction(systemSI *pS, double fraction) {
+    for (int i = 0; i < N; i++) {
+        pS->state[i] = (uniform_pos() < fraction) ? 0 : 1;
+        pS->flag[i] = 1 - pS->state[i];
+    }
+    pS->state[pS->idx0] = 0;
+    pS->flag[pS->idx0] = 1;
+    pS->wheel.dirty = 1;
+}
+
+
+// Print one benchmark record (fraction < 0: kernel independent of the states)
+static void report(systemSI *pS, const char *kernel, double fraction, long steps, double ns, double pairs) {
+    printf("{\"kernel\": \"%s\", \"N\": %d, \"phi\": %g, \"rc\": %g, \"nCells\": %d, ",
+           kernel, N, (double)PHI, (double)RC, pS->nCells);
+    if (fraction < 0.0) printf("\"infected\": null, ");
+    else                printf("\"infected\": %g, ", fraction);
+    printf("\"steps\": %ld, \"ns_per_particle_step\": %.4f", steps, ns / ((double)steps * N));
+    if (pairs > 0.0)
+        printf(", \"pair_checks\": %.0f, \"pair_checks_per_s\": %.6e", pairs, pairs / (ns * 1e-9));
+    printf("}\n");
+}
+
+
+// Time a scalar primitive over BENCH_CALLS calls
+static void reportPrimitive(const char *kernel, double ns) {
+    printf("{\"kernel\": \"%s\", \"calls\": %d, \"ns_per_call\": %.4f}\n",
+           kernel, BENCH_CALLS, ns / BENCH_CALLS);
+}
+
+
+int main(int argc, char **argv) {
+
+    // Command-line options
+    long steps = BENCH_STEPS;            // -n: steps per measurement
+    unsigned int seed = 1;               // -s: random seed
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+            case 'n': steps = atol(optarg); break;
+            case 's': seed = (unsigned int)strtoul(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "Usage: %s [-n steps] [-s seed] [fraction ...]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    // Infected fractions (remaining arguments)
+    double defaultFractions[] = {0.01, 0.1, 0.5};
+    int nFractions = argc - optind;
+    double *fractions = defaultFractions;
+    if (nFractions > 0) {
+        fractions = (double *)malloc(nFractions * sizeof(double));
+        assert(fractions != NULL);
+        for (int k = 0; k < nFractions; k++) fractions[k] = atof(argv[optind + k]);
+    } else {
+        nFractions = sizeof(defaultFractions) / sizeof(defaultFractions[0]);
+    }
+
+    seed_random(seed);
+    systemSI *pS = makeSystem(RC, DT, ALPHA, SIGMA, DIM, COORDINATION);
+
+    // Position update and cell assignment do not depend on the states
+    double t0 = nowNs();
+    for (long s = 0; s < steps; s++) iteration(pS);
+    report(pS, "iteration", -1.0, steps, nowNs() - t0, 0.0);
+
+    t0 = nowNs();
+    for (long s = 0; s < steps; s++) getCellIndex(pS);
+    report(pS, "getCellIndex", -1.0, steps, nowNs() - t0, 0.0);
+
+    // Propagation kernels at each infected fraction (positions frozen)
+    for (int f = 0; f < nFractions; f++) {
+        for (int k = 0; k < nPropagationKernels; k++) {
+            const kernelInfo *e = &propagationKernels[k];
+            char name[32];
+            snprintf(name, sizeof(name), "propagation_%s", e->name);
+            setInfectedFraction(pS, fractions[f]);
+
+            double ns = 0.0, pairs = 0.0;
+            for (long s = 0; s < steps; s++) {
+                pairs += pairCandidates(pS, e->search);
+                t0 = nowNs();
+                sink = e->run(pS, BETA, LAMBDA);
+                ns += nowNs() - t0;
+            }
+            report(pS, name, fractions[f], steps, ns, pairs);
+        }
+    }
+
+    // Scalar primitives
+    double acc = 0.0;
+    t0 = nowNs();
+    for (int c = 0; c < BENCH_CALLS; c++) acc += uniform_pos();
+    reportPrimitive("uniform_pos", nowNs() - t0);
+
+    t0 = nowNs();
+    for (int c = 0; c < BENCH_CALLS; c++) acc += gasdev();
+    reportPrimitive("gasdev", nowNs() - t0);
+
+    real *x = pS->x;
+    t0 = nowNs();
+    for (int c = 0; c < BENCH_CALLS; c++) {
+        int i = c % (DIM * N);
+        acc += minImage(x[i], x[(i + 7) % (DIM * N)]);
+    }
+    reportPrimitive("minImage", nowNs() - t0);
+    sink = acc;
+
+    if (fractions != defaultFractions) free(fractions);
+    destroySystem(pS);
+
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "config.h"
+#include "density.h"
+
+// Convert a density field file written by main -d to text
+//   ./density2dat FILE          list frames: index, step, time, infected
+//   ./density2dat FILE FRAME    cells of a frame: x, y, all, infected (cell centers)
+int main(int argc, char **argv) {
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s FILE [frame]\n", argv[0]);
+        return 1;
+    }
+
+    densityHeader h;
+    FILE *fp = openDensityFile(argv[1], &h);
+    if (fp == NULL) return 1;
+
+    int m = h.m;
+    double cellSize = h.lBox / m;
+    printf("# N=%d L=%.6f M=%d dt=%g\n", h.n, h.lBox, m, h.dt);
+
+    float *all = (float *)malloc(m * m * sizeof(float));
+    float *infected = (float *)malloc(m * m * sizeof(float));
+    assert(all != NULL && infected != NULL);
+
+    long wanted = (argc > 2) ? atol(argv[2]) : -1;
+    if (wanted < 0) printf("# Frame\tStep\tTime\tInfected\n");
+
+    densityFrame frame;
+    long k = 0;
+    int found = 0;
+    for (; readDensityFrame(fp, &h, &frame, all, infected); k++) {
+        if (wanted < 0) {
+            printf("%ld\t%lld\t%.4f\t%d\n", k, frame.step, frame.step * h.dt, frame.nInfected);
+        } else if (k == wanted) {
+            printf("# Frame %ld: step %lld, %d infected\n", k, frame.step, frame.nInfected);
+            printf("# x\ty\tAll\tInfected\n");
+            for (int iy = 0; iy < m; iy++)
+                for (int ix = 0; ix < m; ix++)
+                    printf("%.4f\t%.4f\t%.4f\t%.4f\n", (ix + 0.5) * cellSize, (iy + 0.5) * cellSize,
+                           all[iy * m + ix], infected[iy * m + ix]);
+            found = 1;
+            break;
+        }
+    }
+
+    free(all);
+    free(infected);
+    fclose(fp);
+
+    if (wanted >= 0 && !found) {
+        fprintf(stderr, "density2dat: frame %ld not in file (%ld frames)\n", wanted, k);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "config.h"
+#include "recorder.h"
+
+// Convert an event file written by main -r to text
+//   ./events2dat FILE        print events: step, time, type, infectee, infector, distance
+//   ./events2dat FILE count  print the number of events of each type
+int main(int argc, char **argv) {
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s FILE [count]\n", argv[0]);
+        return 1;
+    }
+
+    recorderHeader h;
+    FILE *fp = openEventFile(argv[1], &h);
+    if (fp == NULL) return 1;
+
+    printf("# N=%d L=%.6f dt=%g\n", h.n, h.lBox, h.dt);
+
+    int countOnly = (argc > 2 && strcmp(argv[2], "count") == 0);
+    const char *names[] = {"seed", "infection", "recovery"};
+    long long counts[3] = {0, 0, 0};
+
+    eventRecord *events = (eventRecord *)malloc(RECORDER_BUFFER * sizeof(eventRecord));
+    assert(events != NULL);
+
+    if (!countOnly) printf("# Step\tTime\tType\tInfectee\tInfector\tDistance\n");
+
+    int n;
+    while ((n = readEvents(fp, events, RECORDER_BUFFER)) > 0) {
+        for (int k = 0; k < n; k++) {
+            eventRecord *e = &events[k];
+            if (e->type >= 0 && e->type < 3) counts[e->type]++;
+            if (!countOnly)
+                printf("%lld\t%.4f\t%d\t%d\t%d\t%.6f\n", e->step, e->step * h.dt,
+                       e->type, e->infectee, e->infector, e->distance);
+        }
+    }
+
+    if (countOnly) {
+        printf("# Type\tName\tEvents\n");
+        for (int t = 0; t < 3; t++) printf("%d\t%s\t%lld\n", t, names[t], counts[t]);
+    }
+
+    free(events);
+    fclose(fp);
+
+    return 0;
+}
@@ -15,18 +15,25 @@ DT=${8:-0.01}           # Time step
 BETA=${9:-0.2}          # Recovery rate (I -> S)
 LAMBDA=${10:-2.0}       # Spatial decay of infection
 REALIZ=${11:-1000}      # Number of realizations per sigma
+BATCH=${BATCH:-100}     # Realizations per cached batch
 
 # Compiler settings
 GCC=gcc
-LDFLAGS="-lm"
+LDFLAGS="-lm -lpthread"
 
-# Source files and output
-SRC="meassure.c src/system.c src/random.c"
-OUT="meassure"
+# Source files
+SRC="meassure.c src/system.c src/recorder.c src/offspring.c src/random.c src/instrument.c src/checkpoint.c"
 
 # Output base directory
 OUTPUT_BASE="R0"
 
+# Batches are cached by content, so an interrupted sweep resumes where it
+# stopped and points already computed by another sweep are reused
+source ./sweep_cache.sh
+N_BATCHES=$(( (REALIZ + BATCH - 1) / BATCH ))
+MANIFEST="$CACHE_DIR/manifest.$$"
+: > "$MANIFEST"
+
 # Create output base directory if it doesn't exist
 mkdir -p "$OUTPUT_BASE"
 
@@ -44,11 +51,16 @@ echo "# DT               = ${DT}     (time step)"
 echo "# BETA             = ${BETA}   (recovery rate)"
 echo "# LAMBDA           = ${LAMBDA} (infection decay)"
 echo "# REALIZATION      = ${REALIZ} (realizations per sigma)"
+echo "# BATCH            = ${BATCH}  (${N_BATCHES} batches per sigma)"
+echo "# WORKERS          = ${WORKERS}"
+echo "# CACHE_DIR        = ${CACHE_DIR}"
 echo "# OUTPUT_BASE      = ${OUTPUT_BASE}"
 echo "# =========================================="
 echo ""
 
-# Loop over sigma values using logarithmic spacing
+# Register every sigma value of the sweep
+KEYS=()
+FILES=()
 for ((i=0; i < N_STEPS; i++)); do
     # Calculate SIGMA using logspace formula
     # SIGMA = SIGMA_MIN * (SIGMA_MAX/SIGMA_MIN)^(i/(N_STEPS-1))
@@ -69,29 +81,34 @@ for ((i=0; i < N_STEPS; i++)); do
     # Create filename with all parameters
     FILENAME="${OUTPUT_BASE}/data_phi${PHI}_rc${RC}_N${N}_alpha${ALPHA}_sigma${SIGMA_FORMATTED}_beta${BETA}_lambda${LAMBDA}.dat"
     
-    echo "# =========================================="
-    echo "# Iteration $((i+1))/${N_STEPS}: SIGMA = ${SIGMA_FORMATTED}"
-    echo "# Output file: ${FILENAME}"
-    echo "# =========================================="
-    
-    # Compile with current sigma value
-    CFLAGS="-Iinclude -DPHI=${PHI} -DRC=${RC} -DN=${N} -DALPHA=${ALPHA} -DSIGMA=${SIGMA} -DDT=${DT} -DBETA=${BETA} -DLAMBDA=${LAMBDA} -DREALIZATION=${REALIZ}"
-    
-    echo "# Compiling..."
-    $GCC $CFLAGS $SRC $LDFLAGS -o $OUT 2>&1 | grep -i "error" && {
-        echo "# ❌ Compilation failed for SIGMA=${SIGMA_FORMATTED}!"
-        exit 1
-    }
-    
-    # Run simulation and save results
-    echo "# Running simulation..."
-    ./$OUT > "$FILENAME"
+    # The number of realizations is a run argument, not part of the key, so
+    # raising REALIZ only adds batches
+    CFLAGS="-Iinclude -DPHI=${PHI} -DRC=${RC} -DN=${N} -DALPHA=${ALPHA} -DSIGMA=${SIGMA} -DDT=${DT} -DBETA=${BETA} -DLAMBDA=${LAMBDA} ${EXTRA_CFLAGS}"
+    KEY=$(addPoint "$MANIFEST" "$SRC" "$CFLAGS" "-n ${BATCH}" "$BATCH" "$N_BATCHES")
+    KEYS+=("$KEY")
+    FILES+=("$FILENAME")
     
-    # Show file size
-    FILE_SIZE=$(du -h "$FILENAME" | cut -f1)
-    echo "# ✓ Saved to: ${FILENAME} (${FILE_SIZE})"
-    echo ""
+    pointDone "$KEY" "$N_BATCHES" && STATUS="cached" || STATUS="to run"
+    echo "# Sigma $((i+1))/${N_STEPS}: SIGMA = ${SIGMA_FORMATTED} (${STATUS}, key ${KEY:0:12})"
 done
+echo ""
+
+# Compute the missing batches
+echo "# Running simulations..."
+runManifest "$MANIFEST"
+rm -f "$MANIFEST"
+echo ""
+
+# Assemble the results of each sigma
+for ((i=0; i < N_STEPS; i++)); do
+    if assemblePoint "${KEYS[$i]}" "$N_BATCHES" "$BATCH" "${FILES[$i]}"; then
+        FILE_SIZE=$(du -h "${FILES[$i]}" | cut -f1)
+        echo "# ✓ Saved to: ${FILES[$i]} (${FILE_SIZE})"
+    else
+        echo "# ❌ Incomplete: ${FILES[$i]} (batches failed or still running elsewhere; rerun to resume)"
+    fi
+done
+echo ""
 
 echo "# =========================================="
 echo "# ✓ All simulations completed!"
@@ -18,15 +18,20 @@ LAMBDAS=(0.5 1.0 1.5 2.0)
 
 # Compiler settings
 GCC=gcc
-LDFLAGS="-lm"
+LDFLAGS="-lm -lpthread"
 
-# Source files and output
-SRC="main.c src/system.c src/random.c"
-OUT="simulation"
+# Source files
+SRC="main.c src/system.c src/recorder.c src/offspring.c src/random.c src/instrument.c src/checkpoint.c src/trajectory.c src/observables.c src/density.c src/numa.c"
 
 # Output base directory
 OUTPUT_BASE="SERIE"
 
+# Each realization is a cached batch of one run (seed SEED_BASE + r), so an
+# interrupted sweep resumes at the first missing realization
+source ./sweep_cache.sh
+MANIFEST="$CACHE_DIR/manifest.$$"
+: > "$MANIFEST"
+
 # Create output base directory if it doesn't exist
 mkdir -p "$OUTPUT_BASE"
 
@@ -42,51 +47,56 @@ echo "# DT               = ${DT}     (time step)"
 echo "# BETA             = ${BETA}   (recovery rate)"
 echo "# REALIZ           = ${REALIZ} (realizations per lambda)"
 echo "# LAMBDAS          = ${LAMBDAS[@]}"
+echo "# WORKERS          = ${WORKERS}"
+echo "# CACHE_DIR        = ${CACHE_DIR}"
 echo "# OUTPUT_BASE      = ${OUTPUT_BASE}"
 echo "# =========================================="
 echo ""
 
-# Loop over custom lambda values
+# Register every lambda value of the sweep
+KEYS=()
 for LAMBDA in "${LAMBDAS[@]}"; do
+    CFLAGS="-Iinclude -DPHI=${PHI} -DRC=${RC} -DN=${N} -DALPHA=${ALPHA} -DSIGMA=${SIGMA} -DDT=${DT} -DBETA=${BETA} -DLAMBDA=${LAMBDA} ${EXTRA_CFLAGS}"
+    KEY=$(addPoint "$MANIFEST" "$SRC" "$CFLAGS" "" 1 "$REALIZ")
+    KEYS+=("$KEY")
+    
+    pointDone "$KEY" "$REALIZ" && STATUS="cached" || STATUS="to run"
+    echo "# LAMBDA = $(printf "%.4f" $LAMBDA) (${STATUS}, key ${KEY:0:12})"
+done
+echo ""
+
+# Compute the missing realizations
+echo "# Running simulations..."
+runManifest "$MANIFEST"
+rm -f "$MANIFEST"
+echo ""
+
+# Copy the realizations of each lambda value
+for ((l=0; l < ${#LAMBDAS[@]}; l++)); do
     # Format lambda with consistent decimal places
-    LAMBDA_FORMATTED=$(printf "%.4f" $LAMBDA)
+    LAMBDA_FORMATTED=$(printf "%.4f" ${LAMBDAS[$l]})
     
     # Create subdirectory for this lambda value
     LAMBDA_DIR="${OUTPUT_BASE}/lambda_${LAMBDA_FORMATTED}"
     mkdir -p "$LAMBDA_DIR"
     
-    echo "# =========================================="
-    echo "# LAMBDA = ${LAMBDA_FORMATTED}"
-    echo "# Output directory: ${LAMBDA_DIR}"
-    echo "# =========================================="
-    
-    # Run realizations
+    MISSING=0
     for ((r=0; r < REALIZ; r++)); do
-        # Create output file for this realization
-        OUTPUT_FILE="${LAMBDA_DIR}/lambda_${LAMBDA_FORMATTED}_real_${r}.dat"
-        
-        # Compile with current lambda value
-        CFLAGS="-Iinclude -DPHI=${PHI} -DRC=${RC} -DN=${N} -DALPHA=${ALPHA} -DSIGMA=${SIGMA} -DDT=${DT} -DBETA=${BETA} -DLAMBDA=${LAMBDA}"
-        
-        if [ $r -eq 0 ]; then
-            echo "# Compiling..."
-            $GCC $CFLAGS $SRC $LDFLAGS -o $OUT 2>&1 | grep -i "error" && {
-                echo "# ❌ Compilation failed for LAMBDA=${LAMBDA_FORMATTED}!"
-                exit 1
-            }
+        BATCH_FILE="${CACHE_DIR}/${KEYS[$l]}/batch_${r}.dat"
+        if [ -f "$BATCH_FILE" ]; then
+            cp "$BATCH_FILE" "${LAMBDA_DIR}/lambda_${LAMBDA_FORMATTED}_real_${r}.dat"
+        else
+            MISSING=$((MISSING+1))
         fi
-        
-        # Run simulation and save results
-        echo "# Realization $((r+1))/${REALIZ}..."
-        ./$OUT > "$OUTPUT_FILE"
-        
-        # Show progress
-        FILE_SIZE=$(du -h "$OUTPUT_FILE" | cut -f1)
-        echo "# ✓ Saved: ${OUTPUT_FILE} (${FILE_SIZE})"
     done
     
-    echo ""
+    if [ $MISSING -eq 0 ]; then
+        echo "# ✓ Saved ${REALIZ} realizations in: ${LAMBDA_DIR}"
+    else
+        echo "# ❌ ${MISSING}/${REALIZ} realizations missing in: ${LAMBDA_DIR} (rerun to resume)"
+    fi
 done
+echo ""
 
 echo "# =========================================="
 echo "# ✓ All simulations completed!"
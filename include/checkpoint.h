@@ -0,0 +1,54 @@
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+#include "random.h"
+#include "system.h"
+
+// =======================================================
+//   Binary checkpoint/restart of systemSI
+// =======================================================
+
+// File layout: one checkpointHeader followed by the particle arrays, each
+// starting on a CHECKPOINT_ALIGN boundary so the file can be mmap'ed and
+// read in place. Cell lists and neighbor lists are not stored: they are
+// rebuilt deterministically from the positions on load, and the recovery
+// wheel from the stored recovery steps.
+
+#define CHECKPOINT_MAGIC   "SISCKPT"
+#define CHECKPOINT_VERSION 2
+#define CHECKPOINT_ALIGN   64
+
+typedef struct {
+    char magic[8];          // CHECKPOINT_MAGIC
+    unsigned int version;   // CHECKPOINT_VERSION
+    unsigned int sizeReal;  // sizeof the position type (real)
+    long long fileSize;     // Total size of the file in bytes
+
+    // Compile-time parameters (must match the loading binary)
+    int n;                  // Number of particles
+    int maxPerCell;         // MAX_PARTICLES_PER_CELL
+    double lBox;            // Box size L_BOX
+
+    // Runtime parameters
+    int d;                  // Spatial dimension
+    int z;                  // Number of neighbor cells
+    int nCells;             // Number of cells per dimension
+    int idx0;               // Index of the first infected particle
+    long long step;         // Completed integration steps
+    double rc;              // Cutoff radius
+    double dt;              // Time step
+    double cellSize;        // Size of each spatial cell
+    long long wheelNow;     // Clock of the recovery wheel
+    double wheelRate;       // Rate the recovery schedule was drawn with
+    int wheelDirty;         // Schedule must be redrawn
+
+    rngState rng;           // Random generator state at save time
+} checkpointHeader;
+
+// Write the whole system (and RNG state) to a file; returns 0 on success
+int saveSystem(systemSI *, const char *);
+
+// Create a system from a checkpoint file and restore the RNG; NULL on error
+systemSI *loadSystem(const char *);
+
+#endif // __CHECKPOINT_H__
@@ -8,6 +8,27 @@
 #include <string.h>
 #include <assert.h>
 
+// =======================================================
+// Numerical precision
+// =======================================================
+
+// Positions, mobility parameters and pair distances use 'real': double by
+// default, float with -DSINGLE_PRECISION. Accumulated quantities (infection
+// products, time, statistics) stay double in both modes.
+#ifdef SINGLE_PRECISION
+typedef float real;
+#define REAL_EXP   expf
+#define REAL_SQRT  sqrtf
+#define REAL_FMOD  fmodf
+#define REAL_ROUND roundf
+#else
+typedef double real;
+#define REAL_EXP   exp
+#define REAL_SQRT  sqrt
+#define REAL_FMOD  fmod
+#define REAL_ROUND round
+#endif
+
 // =======================================================
 // System parameters
 // =======================================================
@@ -42,6 +63,31 @@
 #define REALIZATION 1000
 #endif
 
+// Steps between checkpoints written by main (-c option)
+#ifndef CHECKPOINT_EVERY
+#define CHECKPOINT_EVERY 10000
+#endif
+
+// Steps between trajectory frames written by main (-t option)
+#ifndef TRAJECTORY_EVERY
+#define TRAJECTORY_EVERY 100
+#endif
+
+// Quantization bits per coordinate in trajectory files (grid of L_BOX / 2^bits)
+#ifndef TRAJECTORY_BITS
+#define TRAJECTORY_BITS 16
+#endif
+
+// Frames between trajectory keyframes (seek granularity)
+#ifndef TRAJECTORY_KEYFRAME
+#define TRAJECTORY_KEYFRAME 50
+#endif
+
+// Steps between instrumentation summaries in main (0 = only at the end, needs -DINSTRUMENT)
+#ifndef INSTRUMENT_EVERY
+#define INSTRUMENT_EVERY 0
+#endif
+
 // Time step for integration
 #ifndef DT
 #define DT 0.01
@@ -68,9 +114,22 @@
 // Spatial dimension (2D system)
 #define DIM 2
 
-// Number of neighbor cells (3x3 grid = 9 cells)
+// Number of neighbor cells for cells of size >= RC (3x3 grid = 9 cells);
+// finer grids use a larger stencil computed in makeSystem
 #define COORDINATION 9
 
+// Cells per cutoff radius (cell size ~ RC / CELL_DIVISIONS); 0 selects 1-3
+// automatically from the density
+#ifndef CELL_DIVISIONS
+#define CELL_DIVISIONS 0
+#endif
+
+// Cost of visiting one stencil cell relative to one pair check
+// (cost model used by the automatic choice of CELL_DIVISIONS)
+#ifndef CELL_VISIT_COST
+#define CELL_VISIT_COST 2.0
+#endif
+
 // =======================================================
 // Derived parameters
 // =======================================================
@@ -78,7 +137,7 @@
 // Box size calculated from density and number of particles
 #define L_BOX (sqrt(N / PHI))
 
-// Number of cells per dimension for spatial partitioning
+// Number of cells per dimension for spatial partitioning (cells of size >= RC)
 #define N_BOX ((int)(L_BOX / RC))
 
 // Maximum number of particles allowed per cell
@@ -86,4 +145,60 @@
 #define MAX_PARTICLES_PER_CELL 62
 #endif
 
+// Bins of the quantized Gaussian used by randomGaussianSigma/Alpha
+// (at most MOBILITY_CLASSES^2 (alpha, sigma) classes)
+#ifndef MOBILITY_CLASSES
+#define MOBILITY_CLASSES 8
+#endif
+
+// Buckets of the recovery timer wheel (power of 2; recoveries further
+// ahead stay in their bucket for another turn)
+#ifndef RECOVERY_WHEEL
+#define RECOVERY_WHEEL 1024
+#endif
+
+// Offspring histogram bins (larger counts share the last bin) and default
+// number of generations followed by the offspring tracker
+#ifndef OFFSPRING_MAX
+#define OFFSPRING_MAX 64
+#endif
+
+#ifndef OFFSPRING_GENERATIONS
+#define OFFSPRING_GENERATIONS 16
+#endif
+
+// Steps between observable lines (#@) in main (0 = off unless set with -o),
+// range of the infected pair correlation in units of rc, and its bins
+#ifndef OBSERVABLES_EVERY
+#define OBSERVABLES_EVERY 0
+#endif
+
+#ifndef OBSERVABLES_RMAX
+#define OBSERVABLES_RMAX 3.0
+#endif
+
+#ifndef OBSERVABLES_BINS
+#define OBSERVABLES_BINS 60
+#endif
+
+// Steps between structure factor lines (#@sk) in main (0 = off unless set
+// with -f), and grid cells per side of the density fields (power of two)
+#ifndef DENSITY_EVERY
+#define DENSITY_EVERY 0
+#endif
+
+#ifndef DENSITY_GRID
+#define DENSITY_GRID 64
+#endif
+
+// Events per buffer of the event recorder (two buffers are used)
+#ifndef RECORDER_BUFFER
+#define RECORDER_BUFFER 65536
+#endif
+
+// Alignment of the arrays carved from the system arena (cache line)
+#ifndef ARENA_ALIGN
+#define ARENA_ALIGN 64
+#endif
+
 #endif // __CONFIG_H__
\ No newline at end of file
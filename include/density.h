@@ -0,0 +1,85 @@
+#ifndef __DENSITY_H__
+#define __DENSITY_H__
+
+#include <stdio.h>
+#include "system.h"
+
+// =======================================================
+//   Density fields and structure factor
+// =======================================================
+//
+// Particles are deposited on an M x M grid (M = DENSITY_GRID, a power of two)
+// with cloud-in-cell weights, all particles and infected ones separately.
+// Both fields are transformed by one complex FFT (all in the real part,
+// infected in the imaginary part; in-tree radix-2 code, no external
+// library) and the radially averaged structure factors
+//   S(k)    = <|rho_k|^2> / N        of all particles
+//   S_II(k) = <|rhoI_k|^2> / N_I     of infected particles
+// are obtained in shells of width 2 pi / L_BOX up to the Nyquist wavenumber.
+// The CIC window and its aliases are divided out with the sum
+// prod_mu (1 - 2/3 sin^2(k_mu h / 2)) (h = L_BOX / M), which is exact for
+// uncorrelated positions (S = 1), so S(k) stays unbiased up to Nyquist
+// for the weakly correlated configurations of this model.
+//
+// Field file layout:
+//   densityHeader
+//   frames: densityFrame + 2 * M * M uint16 (all, then infected; row-major,
+//           y rows of x cells), cell value = q * scale of that field
+
+#define DENSITY_MAGIC   "SISDENS"
+#define DENSITY_VERSION 1
+
+typedef struct {
+    char magic[8];          // DENSITY_MAGIC
+    unsigned int version;   // DENSITY_VERSION
+    int n;                  // Number of particles
+    int m;                  // Grid cells per side
+    int reserved;
+    double lBox;            // Box size
+    double dt;              // Time step
+} densityHeader;
+
+typedef struct {
+    long long step;         // Integration step of the frame
+    int nInfected;          // Infected particles
+    int reserved;
+    double scale[2];        // Particles per quantization level (all, infected)
+} densityFrame;
+
+typedef struct {
+    int m;                  // Grid cells per side
+    int nBins;              // Shells of S(k) (m / 2)
+    double *rho;            // CIC counts, all particles (m * m)
+    double *rhoI;           // CIC counts, infected particles (m * m)
+    double *re, *im;        // FFT work arrays (m * m)
+    double *cosTable, *sinTable; // Twiddle factors (m / 2)
+    int *bitReverse;        // Bit-reversed index of 0..m-1
+    double *window;         // CIC alias sum per mode index (m)
+    double *sk, *skI;       // S(k) and S_II(k) of the last measurement
+    long long *modes;       // Modes per shell
+    int nInfected;          // Infected particles at the last measurement
+    unsigned short *q;      // Quantized field of one frame
+    FILE *fp;               // Field output (NULL if none)
+} densityField;
+
+// Grid of m cells per side; writes fields to filename if it is not NULL,
+// with append continuing an existing file up to pS->step
+densityField *makeDensityField(systemSI *, int m, const char *filename, int append);
+void destroyDensityField(densityField *);
+
+void depositDensity(densityField *, systemSI *);       // CIC fields
+void structureFactor(densityField *);                  // FFT and shells, from the fields
+void measureDensity(densityField *, systemSI *);       // Both, and a field frame if writing
+
+// Wavenumber of each shell, then one line per structure factor (#@sk, #@ski)
+void printDensityHeader(densityField *, FILE *);
+void printStructureFactor(densityField *, systemSI *, FILE *);
+
+// In-place 2D FFT of re + i im (forward, unnormalized)
+void fft2d(densityField *, double *, double *);
+
+// Reader: header check and frame by frame
+FILE *openDensityFile(const char *, densityHeader *);
+int readDensityFrame(FILE *, const densityHeader *, densityFrame *, float *, float *);
+
+#endif // __DENSITY_H__
@@ -0,0 +1,67 @@
+#ifndef __INSTRUMENT_H__
+#define __INSTRUMENT_H__
+
+#include "config.h"
+
+// =======================================================
+//   Optional hot-path instrumentation
+// =======================================================
+//
+// Compiled out unless built with -DINSTRUMENT. When enabled it records the
+// wall time of iteration(), getCellIndex() and the propagation kernels, pair
+// candidates visited vs. pairs found within rc, RNG draws, and a histogram of
+// cell occupancies with a max-occupancy watermark. Cell overflow (more than
+// MAX_PARTICLES_PER_CELL particles) aborts before memory is corrupted.
+
+#ifdef INSTRUMENT
+
+#include "system.h"
+
+// Timed phases
+enum {
+    PHASE_ITERATION,
+    PHASE_CELLS,
+    PHASE_PROPAGATION,
+    N_PHASES
+};
+
+typedef struct {
+    double phaseNs[N_PHASES];         // Wall time per phase
+    long long phaseCalls[N_PHASES];   // Calls per phase
+    long long steps;                  // Calls to iteration()
+    long long pairCandidates;         // Pairs visited in the propagation kernels
+    long long pairsInRange;           // Pairs closer than rc
+    long long rngDraws;               // Calls to uniform_pos()
+    long long cellSamples;            // Cells sampled for the histogram
+    long long occupancy[MAX_PARTICLES_PER_CELL + 1]; // Cells holding k particles
+    int maxOccupancy;                 // Highest occupancy seen
+} instrumentCounters;
+
+extern instrumentCounters instr;
+
+double instrumentNow(void);                     // Monotonic time in ns
+void instrumentOccupancy(systemSI *);           // Add current cell occupancies
+void instrumentOverflow(int, int);              // Report cell overflow and abort
+void instrumentReport(FILE *);                  // Print summary ('#' lines)
+void instrumentReset(void);                     // Zero all counters
+
+#define INSTR_BEGIN(phase)      double instrT0_##phase = instrumentNow()
+#define INSTR_END(phase)        (instr.phaseNs[phase] += instrumentNow() - instrT0_##phase, \
+                                 instr.phaseCalls[phase]++)
+#define INSTR_ADD(field, n)     (instr.field += (n))
+#define INSTR_CHECK_CELL(c, k)  do { if ((k) >= MAX_PARTICLES_PER_CELL) instrumentOverflow((c), (k)); } while (0)
+#define INSTR_OCCUPANCY(pS)     instrumentOccupancy(pS)
+#define INSTR_REPORT(fp)        instrumentReport(fp)
+
+#else
+
+#define INSTR_BEGIN(phase)      ((void)0)
+#define INSTR_END(phase)        ((void)0)
+#define INSTR_ADD(field, n)     ((void)0)
+#define INSTR_CHECK_CELL(c, k)  ((void)0)
+#define INSTR_OCCUPANCY(pS)     ((void)0)
+#define INSTR_REPORT(fp)        ((void)0)
+
+#endif // INSTRUMENT
+
+#endif // __INSTRUMENT_H__
@@ -0,0 +1,50 @@
+#ifndef __NUMA_H__
+#define __NUMA_H__
+
+#include <stdio.h>
+#include "system.h"
+
+// =======================================================
+//   NUMA placement
+// =======================================================
+//
+// The topology is read from sysfs (/sys/devices/system/node); without it
+// (other systems, containers hiding it) the machine is taken as one node and
+// every call below degrades to a no-op. Pages are queried and moved with the
+// move_pages system call directly, so libnuma is not needed.
+//
+// All systemSI arrays live in one arena that makeSystem zeroes, so its pages
+// are first touched by the thread creating the system. Pinning that thread
+// to a node before makeSystem (or loadSystem) places the whole arena there;
+// threads created afterwards (the event writer) inherit the pinning.
+// numaMovePages migrates memory that was touched elsewhere.
+
+typedef struct {
+    int nNodes;             // Nodes with CPUs or memory (at least 1)
+    int nCpus;              // Configured CPUs
+    int *nodeOfCpu;         // Node of each CPU, index into nodeId (-1 if offline or unknown)
+    int *nodeId;            // sysfs number of each node
+    int fromSysfs;          // 0 if the single-node fallback is in use
+} numaTopology;
+
+numaTopology *numaDetect(void);
+void numaFree(numaTopology *);
+
+// Nodes below are sysfs numbers (nodeId entries, as numaReport prints them),
+// which need not be contiguous
+
+// Restrict the calling thread to the CPUs of a node; returns 0, or -1 if
+// the node does not exist or the call fails
+int numaPinNode(const numaTopology *, int node);
+
+// Node holding the page of an address (-1 if unknown)
+int numaNodeOfAddress(const numaTopology *, const void *);
+
+// Move the pages of [address, address + size) to a node; returns the pages
+// that could not be moved, or -1 if the call is not available
+long numaMovePages(const numaTopology *, void *, size_t, int node);
+
+// Nodes and CPUs, the CPU running the caller, and where the arena pages are
+void numaReport(const numaTopology *, systemSI *, FILE *);
+
+#endif // __NUMA_H__
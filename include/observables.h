@@ -0,0 +1,52 @@
+#ifndef __OBSERVABLES_H__
+#define __OBSERVABLES_H__
+
+#include <stdio.h>
+#include "system.h"
+
+// =======================================================
+//   On-the-fly observables
+// =======================================================
+//
+// Computed from x, x0, state and the cell lists, so that mobility and
+// spatial structure can be followed without writing positions:
+//   msd  mean squared displacement from the OU centers x0 (minimum image,
+//        so it saturates at ~L_BOX^2/6 for particles without restoring force)
+//   gr   pair correlation g(r) of infected particles up to rMax, normalized
+//        by a uniform distribution of the same number of infected particles
+//   cl   clusters of infected particles (connected when closer than rc,
+//        labelClusters): count, largest size and the number of each size
+// Each is written as one line starting with "#@<name>", so data filters
+// that drop comment lines are not affected.
+
+typedef struct {
+    double rMax;            // Range of g(r) (at most L_BOX / 2)
+    int nBins;              // Bins of g(r)
+    double binWidth;        // rMax / nBins
+    int nOffsets;           // Cells that can hold a particle within rMax
+    int *offsets;           // Their offsets (di, dj), from cellStencil
+    long long *pairs;       // Ordered infected pairs per bin
+    double *g;              // g(r) of the last measurement
+    int *sizeCount;         // Clusters of each size (1..N)
+    int nInfected;          // Infected particles at the last measurement
+    int nClusters;          // Clusters at the last measurement
+    int largest;            // Largest cluster at the last measurement
+    double msd;             // Mean squared displacement at the last measurement
+} observables;
+
+// rMax in units of length; the cell geometry of the system must not change
+observables *makeObservables(systemSI *, double rMax, int nBins);
+void destroyObservables(observables *);
+
+double meanSquaredDisplacement(systemSI *);
+void infectedPairCorrelation(observables *, systemSI *);  // Fills pairs and g
+void infectedClusters(observables *, systemSI *);         // labelClusters into sizeCount, nClusters, largest
+
+// Refresh the cell lists and compute all of the above
+void measureObservables(observables *, systemSI *);
+
+// Description and bin centers of g(r), then one line per observable
+void printObservablesHeader(observables *, FILE *);
+void printObservables(observables *, systemSI *, FILE *);
+
+#endif // __OBSERVABLES_H__
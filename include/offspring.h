@@ -0,0 +1,43 @@
+#ifndef __OFFSPRING_H__
+#define __OFFSPRING_H__
+
+#include <stdio.h>
+#include "system.h"
+
+// =======================================================
+//   Offspring counting by generation
+// =======================================================
+//
+// Every infection is attributed to one infector (the same sampling as the
+// event recorder) and counted in the infector's current infectious period.
+// When a particle recovers, its period is complete and its offspring count
+// becomes one sample of R_g, g being the generation of that infection
+// (seeds are generation 0, so R_0 is the usual R0). Periods still open when
+// a realization ends are censored and not counted. Kernels only count when
+// pS->offspring is set (propagation_v02..v05).
+
+typedef struct offspringTracker {
+    int *generation;        // Generation of each particle's open period (-1 = none)
+    int *offspring;         // Infections caused in the open period
+    int nGenerations;       // Generations kept (deeper ones are dropped)
+    long long *samples;     // Completed periods per generation
+    double *sum, *sumSq;    // Sum of offspring counts (and squares) per generation
+    long long *histogram;   // [generation][count], counts >= OFFSPRING_MAX in the last bin
+} offspringTracker;
+
+// Allocate a tracker for nGenerations and attach it to the system
+offspringTracker *makeOffspringTracker(systemSI *, int nGenerations);
+void destroyOffspringTracker(offspringTracker *, systemSI *);
+
+// Start a realization: currently infected particles open generation 0
+void startOffspring(offspringTracker *, systemSI *);
+
+// Called from the kernels (slots, not labels)
+void offspringInfection(offspringTracker *, int infectee, int infector);
+void offspringRecovery(offspringTracker *, int idx);
+
+// Per generation: samples, mean, variance and dispersion k (negative binomial)
+void printOffspringStats(offspringTracker *, FILE *);
+void printOffspringDistribution(offspringTracker *, FILE *);  // Histogram rows
+
+#endif // __OFFSPRING_H__
@@ -9,9 +9,20 @@
 //   Random number utilities for C simulations
 // =======================================================
 
+// Complete generator state, enough to resume a stream bit-exactly
+typedef struct {
+    unsigned long long s;   // xorshift64* state
+    int haveSpare;          // Box-Muller spare available
+    double spare;           // Box-Muller spare value
+} rngState;
+
 // Initialize random number generator (seed=0 uses time(NULL))
 void seed_random(unsigned int);
 
+// Save/restore the generator state (used by checkpoints)
+void get_random_state(rngState *);
+void set_random_state(const rngState *);
+
 // Return uniform random number in [0, 1)
 double uniform_pos(void);
 
@@ -0,0 +1,76 @@
+#ifndef __RECORDER_H__
+#define __RECORDER_H__
+
+#include <stdio.h>
+#include <pthread.h>
+#include "system.h"
+
+// =======================================================
+//   Epidemic event recorder
+// =======================================================
+
+// File layout:
+//   recorderHeader
+//   eventRecord, appended in the order the events happen
+//
+// Records are collected in one of two buffers; when it is full it is handed
+// to a writer thread and the simulation continues on the other one. Particles
+// are identified by their original label (pS->index), so files stay valid when
+// particles are regrouped into mobility classes. Nothing is recorded unless
+// pS->rec is set. Recoveries are then recorded by every kernel (the shared
+// recovery wheel), infections only by kernels with kernelInfo.attributes
+// (propagation_v02..v05), so main refuses -r with the others.
+
+#define RECORDER_MAGIC   "SISEVNT"
+#define RECORDER_VERSION 1
+
+// Event types
+enum {
+    EVENT_SEED,        // Infected when recording started (no infector)
+    EVENT_INFECTION,   // Infection by the sampled infector
+    EVENT_RECOVERY     // Infected -> susceptible
+};
+
+typedef struct {
+    char magic[8];          // RECORDER_MAGIC
+    unsigned int version;   // RECORDER_VERSION
+    int n;                  // Number of particles
+    double dt;              // Time step (time = step * dt)
+    double lBox;            // Box size
+} recorderHeader;
+
+typedef struct {
+    long long step;         // Step at which the new state holds
+    int type;               // EVENT_*
+    int infectee;           // Particle changing state
+    int infector;           // Infecting particle, -1 if none
+    float distance;         // Infector-infectee distance, 0 if none
+} eventRecord;
+
+struct recorder {
+    FILE *fp;
+    eventRecord *buffer[2];     // Filled alternately by the simulation
+    int active;                 // Buffer being filled
+    int count;                  // Records in the active buffer
+    int pending;                // Buffer handed to the writer (-1 if none)
+    int pendingCount;           // Records in the pending buffer
+    int stop;                   // Writer must exit once idle
+    long long nEvents;          // Records accepted so far
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+typedef struct recorder recorder;
+
+// Writer: open (or append to) an event file and attach it to the system.
+// Currently infected particles are recorded as EVENT_SEED on a new file.
+recorder *openRecorder(const char *, systemSI *, int append);
+void recordEvent(recorder *, long long, int, int, int, float);
+void flushRecorder(recorder *);               // Write out buffered events
+void closeRecorder(recorder *, systemSI *);   // Flush, detach, close
+
+// Reader: header check and sequential reads
+FILE *openEventFile(const char *, recorderHeader *);
+int readEvents(FILE *, eventRecord *, int);   // Returns records read
+
+#endif // __RECORDER_H__
@@ -0,0 +1,23 @@
+#ifndef __STATS_H__
+#define __STATS_H__
+
+// =======================================================
+//   Two-sample statistical tests
+// =======================================================
+
+// Kolmogorov-Smirnov test of two samples (arrays are sorted in place).
+// Stores the statistic D and returns the p-value.
+double ksTwoSample(double *, int, double *, int, double *);
+
+// Chi-square test of two binned distributions with possibly different
+// totals. Bins with fewer than 5 combined counts are merged with their
+// neighbours. Stores chi2 and the degrees of freedom, returns the p-value.
+double chiSquareTwoSample(const double *, const double *, int, double *, int *);
+
+// Complementary incomplete gamma function Q(a, x)
+double gammq(double, double);
+
+// Kolmogorov distribution tail Q_KS(lambda)
+double probks(double);
+
+#endif // __STATS_H__
@@ -1,12 +1,38 @@
 #ifndef __SYSTEM_H__
 #define __SYSTEM_H__
 
+#include <stdio.h>
+
 // Cell structure for spatial partitioning
 typedef struct {
     int nParticles;        // Number of particles in this cell
     int *particleIndex;    // Array of particle indices in this cell
 } cell;
 
+struct recorder;          // Event recorder (recorder.h)
+struct offspringTracker;  // Offspring counts by generation (offspring.h)
+
+// Particles sharing the same OU parameters, stored contiguously
+typedef struct {
+    int start, end;        // Particle range [start, end)
+    double alpha, sigma;   // OU parameters of the class
+    double expMd;          // exp(-alpha dt)
+    double varFactor;      // Std of the OU increment over dt
+} mobilityClass;
+
+// Scheduled recoveries: the recovery step of each infected particle is drawn
+// once, at infection, and kept in bucket (step mod RECOVERY_WHEEL)
+typedef struct {
+    long now;           // Propagation steps taken (the wheel's own clock)
+    double rate;        // Recovery rate the schedule was drawn with
+    int dirty;          // States changed outside the kernels: redraw on next step
+    long *recoverAt;    // Scheduled recovery step of each particle (-1 = none)
+    int *next, *prev;   // Doubly linked list of each bucket
+    int *head;          // First particle of each bucket (-1 = empty)
+    int *due;           // Particles recovering in the current step
+    int nDue;           // Number of them
+} recoveryWheel;
+
 // Main system structure for SIS epidemic simulation
 typedef struct {
     // Memory sizes for dynamic arrays
@@ -14,63 +40,112 @@ typedef struct {
     size_t memoryIndex;        // Size of index array
     size_t memoryState;        // Size of state arrays
     size_t memoryNeighborCell; // Size of neighbor cell array
+    size_t memoryNeighborShift; // Size of neighbor shift array
     size_t memoryCellList;     // Size of cell list array
     size_t memoryFlag;         // Size for flags array
+    size_t memoryCellStorage;  // Size of the particle slots of all cells
+    size_t memoryClasses;      // Size of the mobility class table
+    size_t memoryWheel;        // Size of the recovery wheel buckets
+    size_t memoryArena;        // Size of the arena holding all arrays
+    void *arena;               // Single aligned allocation for all arrays
     
     // Particle data
-    double *x;          // Current positions [x1, y1, x2, y2, ...]
-    double *x0;         // Equilibrium positions (OU process centers)
-    int *index;         // Particle indices
+    real *x;            // Current positions [x1, y1, x2, y2, ...]
+    real *x0;           // Equilibrium positions (OU process centers)
+    int *index;         // Original label of the particle stored in each slot
     int *state;         // Current epidemic state (0=Infected, 1=Susceptible)
     int *fakeState;     // Temporary state buffer for updates
     int *flag;          // Flags for re-infection
+    double *noInfection; // Per-particle P(no infection) accumulated by pair kernels
+                         // (holds the state draws afterwards when infections are attributed)
     
     // Spatial partitioning structures
     cell *cellList;     // Array of cells for spatial hashing
     int *neighborCell;  // Neighbor cell indices for each cell
+    real *neighborShift; // Periodic image shift (d per entry) of each neighbor cell
     
     // System parameters
     double dt;          // Time step
     double rc;          // Cutoff radius for interactions
-    double *alpha;       // OU process relaxation rate
-    double *sigma;      // OU process noise strength
+    real *alpha;        // OU process relaxation rate
+    real *sigma;        // OU process noise strength
+    mobilityClass *classes; // Particles grouped by (alpha, sigma)
+    int nClasses;       // Number of mobility classes in use
     double cellSize;    // Size of each spatial cell
     int nCells;         // Number of cells per dimension
+    int cellDivisions;  // Cells per cutoff radius (cellSize ~ rc / cellDivisions)
     int d;              // Spatial dimension (typically 2)
-    int z;              // Number of neighbor cells (including self)
+    int z;              // Number of cells in the neighbor stencil (including self)
     int idx0;           // Index of the first infected particle
+    long step;          // Number of completed integration steps
+    recoveryWheel wheel;  // Scheduled recoveries
+    int *cluster;         // Infected cluster (root particle) of each particle, from labelClusters
+    struct recorder *rec; // Event recorder, NULL when not recording
+    struct offspringTracker *offspring; // Offspring counting, NULL when off
 
 } systemSI;
 
-// System initialization and cleanup
+// Propagation kernels share one signature (system, beta, lambda); the value
+// returned depends on the kernel (COUNT_*), 0 if it counts nothing.
+// v00..v04 are instances of one generic kernel (src/propagation_kernel.h).
+typedef int (*propagationKernel)(systemSI *, double, double);
+
+enum { SEARCH_NONE, SEARCH_ALL, SEARCH_IDX0, SEARCH_PAIRS };   // Particles a kernel searches
+enum { COUNT_NONE, COUNT_INFECTED, COUNT_EVER };               // What a kernel returns
+
+typedef struct {
+    const char *name;           // "v00".."v05"
+    propagationKernel run;
+    int search;                 // SEARCH_*
+    int count;                  // COUNT_*
+    int tracksFlag;             // Maintains pS->flag (R0 can be measured)
+    int attributes;             // Reports infectors to the recorder and offspring tracker
+    const char *description;
+} kernelInfo;
+
+extern const kernelInfo propagationKernels[];
+extern const int nPropagationKernels;
+const kernelInfo *findKernel(const char *);   // By name ("v02" or "2"), NULL if unknown
+void printKernels(FILE *);                    // Names and descriptions, one per line
+
+// System initialization and cleanup (z is recomputed from the cell stencil)
 systemSI *makeSystem(double, double, double, double, int, int);
 void destroySystem(systemSI *);
+void resetSystem(systemSI *);        // New positions and states, in place
 
 // Initial setup functions
-void putParticles(systemSI *);       // Initialize particle positions randomly
+void putParticles(systemSI *);       // Uniform x0, stationary OU positions around it
+void relaxParticles(systemSI *);     // Fresh stationary draw of x around fixed x0
 void initialState(systemSI *);       // Set initial epidemic states
 
 // Spatial partitioning functions
 void getCellIndex(systemSI *);       // Assign particles to cells
-void getNeighborList(systemSI *);    // Build neighbor cell list
+void getNeighborList(systemSI *);    // Build neighbor cell list and image shifts
+int cellStencil(double, double, int *); // Cell offsets intersecting the cutoff disk
 
 // Dynamics functions
 void iteration(systemSI *);          // Update particle positions (OU process)
-void propagation_v00(systemSI *, double, double);  // Update epidemic states (version 0)
-void propagation_v01(systemSI *, double, double);  // Update epidemic states (version 1)
-void propagation_v02(systemSI *, double, double);  // Update epidemic states (version 2)
-int propagation_v03(systemSI *, double, double);   // Update epidemic states (version 3)
-int propagation_v04(systemSI *, double, double);   // Update epidemic states (version 3)
+int propagation_v00(systemSI *, double, double);  // Update epidemic states (version 0)
+int propagation_v01(systemSI *, double, double);  // Update epidemic states (version 1)
+int propagation_v02(systemSI *, double, double);  // Update epidemic states (version 2)
+int propagation_v03(systemSI *, double, double);  // Version 2 model around idx0, returns infected
+int propagation_v04(systemSI *, double, double);  // Version 3 with ever-infected flags, returns their count
+int propagation_v05(systemSI *, double, double);  // Version 2 model, each pair visited once
+int measureR0(systemSI *, double, double, long, long *); // One R0 realization (version 4)
 
 // Utility functions
 void verifyParticlesInCells(systemSI *);        // Debug: verify cell assignment
-double minImage(double, double);                // Compute minimum image distance (PBC)
+real minImage(real, real);                      // Compute minimum image distance (PBC)
 void resetInfection(systemSI *);                // Reset the infection and set each flag to 0
+void relinkRecoveries(systemSI *);              // Rebuild wheel buckets from recoverAt
+int labelClusters(systemSI *, int *, int *);    // Infected clusters: count, size histogram, largest
 
-void randomGaussianSigma(systemSI *, double);
+// Mobility parameters (each call regroups particles into mobility classes);
+// the Gaussian ones return -1, leaving the system unchanged, if mean < 0
+int randomGaussianSigma(systemSI *, double);
 void uniformSigma(systemSI *, double);
-
-void randomGaussianAlpha(systemSI *, double);
+int randomGaussianAlpha(systemSI *, double);
 void uniformAlpha(systemSI *, double);
+void groupMobilityClasses(systemSI *);  // Sort particles by class, refresh coefficients
 
 #endif // __SYSTEM_H__
\ No newline at end of file
@@ -0,0 +1,82 @@
+#ifndef __TRAJECTORY_H__
+#define __TRAJECTORY_H__
+
+#include <stdio.h>
+#include "system.h"
+
+// =======================================================
+//   Compressed trajectory files
+// =======================================================
+
+// File layout:
+//   trajectoryHeader
+//   quantized equilibrium positions x0 (n*d uint32)
+//   frames: frameHeader + payload
+//   index:  frame offsets (nFrames int64), nFrames (int64), TRAJECTORY_INDEX_MAGIC
+//
+// Positions are quantized to a grid of 2^bits points per box length. Each
+// coordinate is stored as the zigzag/varint-encoded difference with the
+// previous frame, or with x0 on keyframes (every keyEvery frames), so any
+// frame can be decoded starting from the nearest keyframe. States are packed
+// one bit per particle. The index is written on close; if it is missing the
+// reader rebuilds it by scanning the frames.
+
+#define TRAJECTORY_MAGIC       "SISTRAJ"
+#define TRAJECTORY_INDEX_MAGIC "SISTIDX"
+#define TRAJECTORY_VERSION     1
+
+typedef struct {
+    char magic[8];          // TRAJECTORY_MAGIC
+    unsigned int version;   // TRAJECTORY_VERSION
+    int n;                  // Number of particles
+    int d;                  // Spatial dimension
+    int bits;               // Quantization bits per coordinate
+    int keyEvery;           // Frames between keyframes
+    int reserved;
+    double lBox;            // Box size
+    double dt;              // Time step
+} trajectoryHeader;
+
+typedef struct {
+    long long step;         // Integration step of the frame
+    unsigned int size;      // Payload size in bytes
+    int keyframe;           // 1 if deltas are taken against x0
+} frameHeader;
+
+// Writer state
+typedef struct {
+    FILE *fp;
+    trajectoryHeader h;
+    unsigned int *q;        // Quantized positions of the previous frame
+    unsigned int *q0;       // Quantized equilibrium positions
+    unsigned char *buffer;  // Encoding buffer for one frame
+    long long *offsets;     // File offset of each frame
+    long nFrames;           // Number of frames written
+    long capFrames;         // Capacity of offsets
+} trajectoryWriter;
+
+// Reader state
+typedef struct {
+    FILE *fp;
+    trajectoryHeader h;
+    unsigned int *q;        // Quantized positions of the current frame
+    unsigned int *q0;       // Quantized equilibrium positions
+    unsigned char *buffer;  // Decoding buffer for one frame
+    long long *offsets;     // File offset of each frame
+    long nFrames;           // Number of frames in the file
+    long current;           // Frame held in q (-1 if none)
+} trajectoryReader;
+
+// Writer: create file (bits per coordinate, frames between keyframes), or
+// with append continue an existing file, dropping frames from pS->step on
+trajectoryWriter *openTrajectory(const char *, systemSI *, int, int, int);
+int writeFrame(trajectoryWriter *, systemSI *);
+void closeTrajectory(trajectoryWriter *);
+
+// Reader: random access to frames (positions, states and step of a frame)
+trajectoryReader *openTrajectoryReader(const char *);
+int readFrame(trajectoryReader *, long, double *, int *, long long *);
+void readEquilibrium(trajectoryReader *, double *);
+void closeTrajectoryReader(trajectoryReader *);
+
+#endif // __TRAJECTORY_H__
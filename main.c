@@ -1,8 +1,16 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include "config.h"
 #include "random.h"
 #include "system.h"
+#include "checkpoint.h"
+#include "instrument.h"
+#include "trajectory.h"
+#include "recorder.h"
+#include "observables.h"
+#include "density.h"
+#include "numa.h"
 
 // Count the number of susceptible and infected particles
 void countStates(systemSI *pS, int *nSusceptible, int *nInfected) {
@@ -18,10 +26,56 @@ void countStates(systemSI *pS, int *nSusceptible, int *nInfected) {
     }
 }
 
-int main() {
+int main(int argc, char **argv) {
+
+    // Command-line options
+    const char *checkpointFile = NULL;   // -c: checkpoint file (resumed if it exists)
+    long checkpointEvery = CHECKPOINT_EVERY; // -e: steps between checkpoints
+    const char *trajectoryFile = NULL;   // -t: compressed trajectory output
+    long trajectoryEvery = TRAJECTORY_EVERY; // -k: steps between trajectory frames
+    const char *eventFile = NULL;        // -r: infection/recovery event output
+    unsigned int seed = 0;               // -s: random seed (0 uses time)
+    long observablesEvery = OBSERVABLES_EVERY; // -o: steps between observables (0 = off)
+    long densityEvery = DENSITY_EVERY;   // -f: steps between structure factors (0 = off)
+    const char *densityFile = NULL;      // -d: density field output (at the -f steps)
+    int numaNode = -1;                   // -n: NUMA node (sysfs number) to run on (-1: not pinned)
+    const char *kernelName = "v02";      // -v: propagation kernel
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:e:t:k:r:s:o:f:d:n:v:")) != -1) {
+        switch (opt) {
+            case 'c': checkpointFile = optarg; break;
+            case 'e': checkpointEvery = atol(optarg); break;
+            case 't': trajectoryFile = optarg; break;
+            case 'k': trajectoryEvery = atol(optarg); break;
+            case 'r': eventFile = optarg; break;
+            case 's': seed = (unsigned int)strtoul(optarg, NULL, 10); break;
+            case 'o': observablesEvery = atol(optarg); break;
+            case 'f': densityEvery = atol(optarg); break;
+            case 'd': densityFile = optarg; break;
+            case 'n': numaNode = atoi(optarg); break;
+            case 'v': kernelName = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-c checkpoint] [-e every] [-t trajectory] [-k every] [-r events] [-s seed] [-o every] [-f every] [-d fields] [-n node] [-v kernel]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    const kernelInfo *kernel = findKernel(kernelName);
+    if (kernel == NULL) {
+        fprintf(stderr, "Unknown kernel: %s. Kernels:\n", kernelName);
+        printKernels(stderr);
+        return 1;
+    }
+
+    // Event files need the infector of every infection
+    if (eventFile != NULL && !kernel->attributes) {
+        fprintf(stderr, "-r needs a kernel that records infections (not %s)\n", kernel->name);
+        return 1;
+    }
+
     // Initialize random seed
-    srand(time(NULL));
-    seed_random(0);
+    seed_random(seed);
     
     // System parameters
     double rc = RC;        // Cutoff radius
@@ -35,10 +89,29 @@ int main() {
     double beta = BETA;      // Recovery rate (I -> S)
     double lambda = LAMBDA;    // Spatial decay of infection
     
-    // Create system
-    printf("# Creating system...\n");
-    systemSI *pS = makeSystem(rc, dt, alpha, sigma, d, z);
-    printf("# System created with N=%d particles\n\n", N);
+    // Pin to a NUMA node before the arena is first touched, so the system
+    // (and the event writer thread) stays on that node
+    numaTopology *numa = numaDetect();
+    if (numaNode >= 0 && numaPinNode(numa, numaNode) != 0) return 1;
+    
+    // Create system, or resume it from the checkpoint
+    systemSI *pS = NULL;
+    int resumed = 0;
+    if (checkpointFile != NULL && access(checkpointFile, F_OK) == 0) {
+        printf("# Resuming from %s...\n", checkpointFile);
+        pS = loadSystem(checkpointFile);
+        if (pS == NULL) return 1;
+        resumed = 1;
+        printf("# System restored at step %ld\n\n", pS->step);
+    } else {
+        printf("# Creating system...\n");
+        pS = makeSystem(rc, dt, alpha, sigma, d, z);
+        printf("# System created with N=%d particles\n\n", N);
+    }
+    printf("# Kernel: %s (%s)\n", kernel->name, kernel->description);
+    
+    numaReport(numa, pS, stdout);
+    printf("\n");
     
     // Initial state
     int nS, nI;
@@ -49,26 +122,94 @@ int main() {
     // Simulation parameters
     int nSteps = 100000;
     int printEvery = 100;
+    long instrumentEvery = INSTRUMENT_EVERY;
+
+    // Trajectory output (continued when resuming)
+    trajectoryWriter *tw = NULL;
+    if (trajectoryFile != NULL && trajectoryEvery > 0) {
+        tw = openTrajectory(trajectoryFile, pS, TRAJECTORY_BITS, TRAJECTORY_KEYFRAME, resumed);
+        if (tw == NULL) return 1;
+    }
+    
+    // Event output (continued when resuming)
+    recorder *rec = NULL;
+    if (eventFile != NULL) {
+        rec = openRecorder(eventFile, pS, resumed);
+        if (rec == NULL) return 1;
+    }
+    
+    // Observables (MSD, infected g(r), clusters) as #@ lines
+    observables *obs = NULL;
+    if (observablesEvery > 0) {
+        obs = makeObservables(pS, OBSERVABLES_RMAX * rc, OBSERVABLES_BINS);
+        printObservablesHeader(obs, stdout);
+    }
+    
+    // Structure factors as #@ lines, density fields to a file (continued
+    // when resuming)
+    densityField *density = NULL;
+    if (densityFile != NULL && densityEvery <= 0) {
+        fprintf(stderr, "-d needs -f STEPS\n");
+        return 1;
+    }
+    if (densityEvery > 0) {
+        density = makeDensityField(pS, DENSITY_GRID, densityFile, resumed);
+        if (density == NULL) return 1;
+        printDensityHeader(density, stdout);
+    }
     
     printf("# Starting simulation...\n");
     printf("# Step\tTime\t\tS\tI\n");
     
     // Main simulation loop
-    for (int step = 0; step <= nSteps; step++) {
+    for (long step = pS->step; step <= nSteps; step++) {
         if (step % printEvery == 0) {
             countStates(pS, &nS, &nI);
-            printf("%d\t%.4f\t\t%d\t%d\n", step, step * dt, nS, nI);
+            printf("%ld\t%.4f\t\t%d\t%d\n", step, step * dt, nS, nI);
+        }
+
+        if (instrumentEvery > 0 && step > 0 && step % instrumentEvery == 0) {
+            INSTR_REPORT(stdout);
+        }
+
+        if (tw != NULL && step % trajectoryEvery == 0) {
+            writeFrame(tw, pS);
+        }
+
+        if (obs != NULL && step % observablesEvery == 0) {
+            measureObservables(obs, pS);
+            printObservables(obs, pS, stdout);
+        }
+
+        if (density != NULL && step % densityEvery == 0) {
+            measureDensity(density, pS);
+            printStructureFactor(density, pS, stdout);
         }
         
         // Update system
         iteration(pS);           // Update particle positions
         getCellIndex(pS);        // Update cell lists
-        propagation_v02(pS, beta, lambda);  // Update epidemic states
+        kernel->run(pS, beta, lambda);      // Update epidemic states
+
+        // Periodic checkpoint (pS->step == step + 1 here)
+        if (checkpointFile != NULL && checkpointEvery > 0 && pS->step % checkpointEvery == 0) {
+            fflush(stdout);
+            flushRecorder(rec);
+            if (tw != NULL) fflush(tw->fp);
+            if (density != NULL && density->fp != NULL) fflush(density->fp);
+            saveSystem(pS, checkpointFile);
+        }
     }
     
     printf("# Simulation completed.\n");
+    INSTR_REPORT(stdout);
     
     // Free memory
+    closeRecorder(rec, pS);
+    closeTrajectory(tw);
+    destroyObservables(obs);
+    destroyDensityField(density);
+    numaFree(numa);
     destroySystem(pS);
     
     return 0;
@@ -1,8 +1,12 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include "config.h"
 #include "random.h"
 #include "system.h"
+#include "checkpoint.h"
+#include "instrument.h"
+#include "offspring.h"
 
 // Count the number of susceptible and infected particles
 void countStates(systemSI *pS, int *nSusceptible, int *nInfected) {
@@ -18,11 +22,43 @@ void countStates(systemSI *pS, int *nSusceptible, int *nInfected) {
     }
 }
 
-int main() {
+int main(int argc, char **argv) {
+
+    // Command-line options
+    const char *snapshotFile = NULL;     // -l: equilibrated snapshot to start every realization from
+    unsigned int seed = 0;               // -s: random seed (0 uses time)
+    int nGenerations = 0;                // -g: offspring by generation (0: R0 from idx0)
+    int nSteps = 10000;                  // -m: maximum steps per realization
+    int nRealizations = REALIZATION;     // -n: number of realizations
+    const char *kernelName = "v02";      // -v: propagation kernel of the generation mode
+
+    int opt;
+    while ((opt = getopt(argc, argv, "l:s:g:m:n:v:")) != -1) {
+        switch (opt) {
+            case 'l': snapshotFile = optarg; break;
+            case 's': seed = (unsigned int)strtoul(optarg, NULL, 10); break;
+            case 'g': nGenerations = atoi(optarg); break;
+            case 'm': nSteps = atoi(optarg); break;
+            case 'n': nRealizations = atoi(optarg); break;
+            case 'v': kernelName = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-l snapshot] [-s seed] [-g generations] [-m steps] [-n realizations] [-v kernel]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    // The R0 mode follows idx0 with v04 (-v is not used); the generation
+    // mode needs a kernel that lets every infected particle infect and
+    // reports who did
+    const kernelInfo *kernel = findKernel(kernelName);
+    if (nGenerations > 0 && (kernel == NULL || !kernel->attributes || kernel->search == SEARCH_IDX0)) {
+        fprintf(stderr, "%s kernel: %s. Kernels:\n", kernel == NULL ? "Unknown" : "Unsuitable", kernelName);
+        printKernels(stderr);
+        return 1;
+    }
 
     // Initialize random seed
-    srand(time(NULL));
-    seed_random(0);
+    seed_random(seed);
     
     // System parameters
     double rc = RC;        // Cutoff radius
@@ -36,10 +72,29 @@ int main() {
     double beta = BETA;      // Recovery rate (I -> S)
     double lambda = LAMBDA;    // Spatial decay of infection
     
-    // Create system
-    printf("# Creating system...\n");
-    systemSI *pS = makeSystem(rc, dt, alpha, sigma, d, z);
-    printf("# System created with N=%d particles\n\n", N);
+    // Create system, or start from the snapshot
+    systemSI *pS = NULL;
+    real *snapshotX = NULL;
+    if (snapshotFile != NULL) {
+        printf("# Loading snapshot %s...\n", snapshotFile);
+        pS = loadSystem(snapshotFile);
+        if (pS == NULL) return 1;
+
+        // Reseed so that processes fanned out from one snapshot are independent
+        seed_random(seed);
+        uniformSigma(pS, sigma);
+        uniformAlpha(pS, alpha);
+        initialState(pS);
+
+        snapshotX = (real *)malloc(pS->memoryX);
+        assert(snapshotX != NULL);
+        memcpy(snapshotX, pS->x, pS->memoryX);
+        printf("# Snapshot taken at step %ld\n\n", pS->step);
+    } else {
+        printf("# Creating system...\n");
+        pS = makeSystem(rc, dt, alpha, sigma, d, z);
+        printf("# System created with N=%d particles\n\n", N);
+    }
     
     // Initial state
     int nS, nI;
@@ -47,39 +102,62 @@ int main() {
     printf("# Initial state:\n");
     printf("# Susceptibles: %d, Infected: %d\n\n", nS, nI);
     
-    // Simulation parameters
-    int nSteps = 10000;
+    // Generation mode: follow the whole outbreak (kernel of -v) and count
+    // the offspring of every infectious period
+    offspringTracker *tracker = NULL;
+    if (nGenerations > 0) {
+        tracker = makeOffspringTracker(pS, nGenerations);
+        startOffspring(tracker, pS);
+    }
     
     printf("# Starting simulation...\n");
-    printf("# Relz\tStep\tTime\tsigma\tR0\n");
+    if (tracker != NULL) printf("# Kernel: %s (%s)\n# Relz\tStep\tTime\tInfected\n", kernel->name, kernel->description);
+    else printf("# Relz\tStep\tTime\tsigma\tR0\n");
     
-    for (int relz = 0; relz < REALIZATION; relz++) {
+    for (int relz = 0; relz < nRealizations; relz++) {
         
-        // Main simulation loop
-        int idx0 = pS -> idx0;
-        int r0 = 0;
-        int step; for (step = 0; step <= nSteps && !pS -> state[idx0]; step++) {
-
-            // Update system
-            iteration(pS);                            // Update particle positions
-            getCellIndex(pS);                         // Update cell lists
-            r0  = propagation_v04(pS, beta, lambda);
+        if (tracker != NULL) {
+            // Until extinction (periods still open at nSteps are censored)
+            int step; for (step = 0; step <= nSteps; step++) {
+                countStates(pS, &nS, &nI);
+                if (nI == 0) break;
+                iteration(pS);
+                getCellIndex(pS);
+                kernel->run(pS, beta, lambda);
+            }
+            printf("%d\t%d\t%.4f\t%d\n", relz, step, step * dt, nI);
+        } else {
+            // Until idx0 recovers
+            long step;
+            int r0 = measureR0(pS, beta, lambda, nSteps, &step);
+            printf("%d\t%ld\t%.4f\t%d\n", relz, step, step * dt, r0);
         }
 
-    
-        //countStates(pS, &nS, &nI);
-        printf("%d\t%d\t%.4f\t%d\n", relz, step, step * dt, r0);
-
-        pS -> sigma = sigma;
-        
-        // Set initial epidemic states
-        initialState(pS);
+        // Restart every realization from the same snapshot configuration,
+        // otherwise from fresh stationary positions and a new infected particle
+        if (snapshotX != NULL) {
+            memcpy(pS->x, snapshotX, pS->memoryX);
+            getCellIndex(pS);
+            initialState(pS);
+        } else {
+            resetSystem(pS);
+        }
+        if (tracker != NULL) startOffspring(tracker, pS);
 
     }
     
     printf("# Simulation completed.\n");
+    if (tracker != NULL) {
+        printf("\n# Offspring by generation\n");
+        printOffspringStats(tracker, stdout);
+        printf("\n# Offspring distribution\n");
+        printOffspringDistribution(tracker, stdout);
+    }
+    INSTR_REPORT(stdout);
     
     // Free memory
+    free(snapshotX);
+    destroyOffspringTracker(tracker, pS);
     destroySystem(pS);
     
     return 0;
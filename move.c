@@ -7,6 +7,9 @@
 #include <GL/glut.h>
 #include <string.h>
 #include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
 
 // Particle visual size for rendering
 #define PARTICLE_RADIUS 0.2
@@ -14,7 +17,71 @@
 // Number of segments to approximate circles
 #define NUM_SEGMENTS 16
 
-systemSI *pS = NULL;
+// Vertices and indices of one particle in the batched circle mesh
+#define CIRCLE_VERTICES (NUM_SEGMENTS + 1)
+#define CIRCLE_INDICES  (3 * NUM_SEGMENTS)
+
+// Capacity of the UI -> simulation command queue
+#define COMMAND_QUEUE_SIZE 64
+
+// Triple buffer: index of the middle snapshot plus a "new data" bit
+#define SNAPSHOT_INDEX 3
+#define SNAPSHOT_NEW   4
+
+// Particle rendering modes
+#define RENDER_CIRCLES 0   // Batched triangle mesh, one draw call
+#define RENDER_POINTS  1   // One smoothed point per particle, one draw call
+
+systemSI *pS = NULL;   // Owned by the simulation thread once it is started
+const kernelInfo *kernel = NULL;   // Propagation kernel (-v, default v02)
+
+// =======================================================
+//   Simulation thread and its communication with the UI
+// =======================================================
+//
+// The simulation runs on its own thread. After every batch of steps it
+// copies positions and states into the back snapshot of a triple buffer and
+// swaps it with the middle one; the display callback swaps the middle one
+// with its front snapshot when new data is flagged. Neither side blocks.
+// The UI never touches pS: parameter changes, infections and toggles are
+// sent through a single-producer/single-consumer command queue.
+
+// Positions and states published by the simulation
+typedef struct {
+    real *x;
+    int *state;
+    int *index;        // Label of the particle in each slot (slots move when classes regroup)
+    long step;
+} snapshot;
+
+snapshot snapshots[3];
+int backSnapshot = 0;                          // Simulation thread only
+int frontSnapshot = 1;                         // Display only
+atomic_int middleSnapshot = 2;                 // Shared, SNAPSHOT_NEW when unread
+
+// Commands from the UI thread to the simulation thread
+enum {
+    CMD_ALPHA,             // Set alpha (value), uniform or Gaussian (flag)
+    CMD_SIGMA,             // Set sigma (value), uniform or Gaussian (flag)
+    CMD_BETA,              // Set recovery rate (value)
+    CMD_LAMBDA,            // Set infection decay (value)
+    CMD_INFECT,            // Infect particle (flag: label, pS->index)
+    CMD_RESET_INFECTION    // Reset all states
+};
+
+typedef struct {
+    int type;
+    int flag;
+    double value;
+} command;
+
+command commandQueue[COMMAND_QUEUE_SIZE];
+atomic_uint commandHead = 0;   // Next command to run (simulation thread)
+atomic_uint commandTail = 0;   // Next free slot (UI thread)
+
+pthread_t simulationThread;
+atomic_int simulationRunning = 0;
+atomic_int stepsPerFrame = 1;  // Steps between snapshots (0 = full speed)
 
 // Zoom settings for orthographic projection
 double zoomLeft;
@@ -31,7 +98,7 @@ GLint windowHeight = 800;
 // Global visualization parameters
 GLint FPS = 20;      // Frames per second
 GLint viewMode = 0;  // Display mode toggle
-GLint pause = 1;     // Pause/resume simulation
+atomic_int paused = 1; // Pause/resume simulation
 GLint nView = 1;     // Number of available views
 GLint gridView = 0;  // Show/hide cell grid
 
@@ -41,6 +108,18 @@ GLint showUI = 1;    // Show/hide UI panel
 GLfloat unifSigma = 1;
 GLfloat unifAlpha = 1;
 
+// Batched particle rendering
+GLint renderMode = RENDER_CIRCLES;
+GLfloat circleTemplate[2 * CIRCLE_VERTICES];  // Unit circle: center, then the ring
+GLfloat *vertexBuffer = NULL;                 // Vertex positions, rebuilt every frame
+GLubyte *colorBuffer = NULL;                  // Vertex colors, rebuilt every frame
+GLuint *indexBuffer = NULL;                   // Triangles of all circles, built once
+
+// Frame rate measurement
+int frameCount = 0;
+int frameTimeBase = 0;
+double measuredFPS = 0.0;
+
 // Button structure
 typedef struct {
     float x, y, width, height;
@@ -65,6 +144,154 @@ double currentBeta = BETA;
 double currentSigma = SIGMA;
 
 
+// Queue a command for the simulation thread (UI thread only)
+void pushCommand(int type, int flag, double value) {
+    unsigned tail = atomic_load_explicit(&commandTail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&commandHead, memory_order_acquire);
+    if (tail - head == COMMAND_QUEUE_SIZE) {
+        fprintf(stderr, "Warning: command queue full, command dropped\n");
+        return;
+    }
+    commandQueue[tail % COMMAND_QUEUE_SIZE] = (command){type, flag, value};
+    atomic_store_explicit(&commandTail, tail + 1, memory_order_release);
+}
+
+
+// Run all queued commands on the system (simulation thread only)
+int runCommands(double *beta, double *lambda) {
+    unsigned head = atomic_load_explicit(&commandHead, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&commandTail, memory_order_acquire);
+    int nCommands = tail - head;
+
+    for (; head != tail; head++) {
+        command *cmd = &commandQueue[head % COMMAND_QUEUE_SIZE];
+        switch (cmd->type) {
+            case CMD_ALPHA:
+                if (cmd->flag) randomGaussianAlpha(pS, cmd->value);
+                else           uniformAlpha(pS, cmd->value);
+                break;
+            case CMD_SIGMA:
+                if (cmd->flag) randomGaussianSigma(pS, cmd->value);
+                else           uniformSigma(pS, cmd->value);
+                break;
+            case CMD_BETA:
+                *beta = cmd->value;
+                break;
+            case CMD_LAMBDA:
+                *lambda = cmd->value;
+                break;
+            case CMD_INFECT:
+                for (int i = 0; i < N; i++) {
+                    if (pS->index[i] != cmd->flag) continue;
+                    pS->state[i] = 0;      // 0 = infected
+                    pS->wheel.dirty = 1;   // Schedule its recovery
+                    break;
+                }
+                break;
+            case CMD_RESET_INFECTION:
+                resetInfection(pS);
+                break;
+        }
+    }
+    atomic_store_explicit(&commandHead, head, memory_order_release);
+    return nCommands;
+}
+
+
+// Copy the system into the back snapshot and swap it with the middle one
+void publishSnapshot() {
+    snapshot *sn = &snapshots[backSnapshot];
+    memcpy(sn->x, pS->x, pS->memoryX);
+    memcpy(sn->state, pS->state, pS->memoryState);
+    memcpy(sn->index, pS->index, pS->memoryIndex);
+    sn->step = pS->step;
+
+    int old = atomic_exchange_explicit(&middleSnapshot, backSnapshot | SNAPSHOT_NEW,
+                                       memory_order_acq_rel);
+    backSnapshot = old & SNAPSHOT_INDEX;
+}
+
+
+// Take the latest published snapshot, if any (display only)
+snapshot *acquireSnapshot() {
+    if (atomic_load_explicit(&middleSnapshot, memory_order_acquire) & SNAPSHOT_NEW) {
+        int old = atomic_exchange_explicit(&middleSnapshot, frontSnapshot, memory_order_acq_rel);
+        frontSnapshot = old & SNAPSHOT_INDEX;
+    }
+    return &snapshots[frontSnapshot];
+}
+
+
+// Simulation thread: run commands, advance the system, publish snapshots
+void *simulationLoop(void *arg) {
+    (void)arg;
+    double beta = currentBeta;
+    double lambda = currentLambda;
+
+    while (atomic_load(&simulationRunning)) {
+        int changed = runCommands(&beta, &lambda);
+
+        if (atomic_load(&paused)) {
+            if (changed) publishSnapshot();
+            usleep(1000);
+            continue;
+        }
+
+        // With a steps-per-frame target, wait until the last frame was shown
+        int steps = atomic_load(&stepsPerFrame);
+        if (steps > 0 && (atomic_load(&middleSnapshot) & SNAPSHOT_NEW)) {
+            if (changed) publishSnapshot();
+            usleep(500);
+            continue;
+        }
+
+        for (int k = 0; k < (steps > 0 ? steps : 1); k++) {
+            iteration(pS);  // Update particle positions
+
+            kernel->run(pS, beta, lambda);  // Propagation model chosen with -v (using current values)
+        }
+        publishSnapshot();
+    }
+    return NULL;
+}
+
+
+// Allocate the snapshots and start the simulation thread
+void startSimulation() {
+    for (int k = 0; k < 3; k++) {
+        snapshots[k].x = (real *)malloc(pS->memoryX);
+        snapshots[k].state = (int *)malloc(pS->memoryState);
+        snapshots[k].index = (int *)malloc(pS->memoryIndex);
+        assert(snapshots[k].x != NULL && snapshots[k].state != NULL && snapshots[k].index != NULL);
+    }
+
+    // Every snapshot starts as a copy of the initial system
+    for (int k = 0; k < 3; k++) {
+        memcpy(snapshots[k].x, pS->x, pS->memoryX);
+        memcpy(snapshots[k].state, pS->state, pS->memoryState);
+        memcpy(snapshots[k].index, pS->index, pS->memoryIndex);
+        snapshots[k].step = pS->step;
+    }
+
+    atomic_store(&simulationRunning, 1);
+    int status = pthread_create(&simulationThread, NULL, simulationLoop, NULL);
+    assert(status == 0);
+}
+
+
+// Stop the simulation thread and free the snapshots
+void stopSimulation() {
+    atomic_store(&simulationRunning, 0);
+    pthread_join(simulationThread, NULL);
+
+    for (int k = 0; k < 3; k++) {
+        free(snapshots[k].x);
+        free(snapshots[k].state);
+        free(snapshots[k].index);
+    }
+}
+
+
 // Initialize UI buttons
 void initButtons() {
     float startX = 15.0f;
@@ -259,19 +486,12 @@ void updateParameter(int paramType, int isIncrement) {
         if (*param < 0.0) *param = 0.0; // Prevent negative values
     }
     
-    // Update system parameters (if applicable)
-    if (paramType == 0 && pS != NULL) {
-        if (unifAlpha){
-            uniformAlpha(pS, currentAlpha);
-        } else {
-            randomGaussianAlpha(pS, currentAlpha);
-        }
-    } else if (paramType == 3 && pS != NULL) {
-        if (unifSigma){
-            uniformSigma(pS, currentSigma);
-        } else {
-            randomGaussianSigma(pS, currentSigma);
-        }
+    // Send the new value to the simulation thread
+    switch (paramType) {
+        case 0: pushCommand(CMD_ALPHA, !unifAlpha, currentAlpha); break;
+        case 1: pushCommand(CMD_LAMBDA, 0, currentLambda); break;
+        case 2: pushCommand(CMD_BETA, 0, currentBeta); break;
+        case 3: pushCommand(CMD_SIGMA, !unifSigma, currentSigma); break;
     }
     
     printf("%s updated to: %.3f\n", paramName, *param);
@@ -287,6 +507,42 @@ void setZoomForSystem() {
 }
 
 
+// Precompute the unit circle and the triangle indices of all particles
+void initRenderBuffers() {
+    circleTemplate[0] = 0.0f;
+    circleTemplate[1] = 0.0f;
+    for (int k = 0; k < NUM_SEGMENTS; k++) {
+        float theta = k * (2.0f * M_PI / NUM_SEGMENTS);
+        circleTemplate[2 * (k + 1) + 0] = cosf(theta);
+        circleTemplate[2 * (k + 1) + 1] = sinf(theta);
+    }
+
+    vertexBuffer = (GLfloat *)malloc(2 * CIRCLE_VERTICES * N * sizeof(GLfloat));
+    colorBuffer = (GLubyte *)malloc(3 * CIRCLE_VERTICES * N * sizeof(GLubyte));
+    indexBuffer = (GLuint *)malloc(CIRCLE_INDICES * N * sizeof(GLuint));
+    assert(vertexBuffer != NULL && colorBuffer != NULL && indexBuffer != NULL);
+
+    // Fan of each circle as independent triangles: center, k, k+1
+    for (int i = 0; i < N; i++) {
+        GLuint base = i * CIRCLE_VERTICES;
+        GLuint *idx = indexBuffer + i * CIRCLE_INDICES;
+        for (int k = 0; k < NUM_SEGMENTS; k++) {
+            idx[3 * k + 0] = base;
+            idx[3 * k + 1] = base + 1 + k;
+            idx[3 * k + 2] = base + 1 + (k + 1) % NUM_SEGMENTS;
+        }
+    }
+}
+
+
+// Free the rendering buffers
+void destroyRenderBuffers() {
+    free(vertexBuffer);
+    free(colorBuffer);
+    free(indexBuffer);
+}
+
+
 // Initialize OpenGL and create the simulation system
 void initOpenGL() {
 
@@ -326,30 +582,21 @@ void initOpenGL() {
     // Initialize UI buttons
     initButtons();
 
+    // Particle mesh and vertex buffers
+    initRenderBuffers();
+
+    // Run the simulation on its own thread from now on
+    startSimulation();
+
     // Print system information
     printf("System created:\n");
     printf("  Particles: %d\n", N);
-    printf("  Cells: %dx%d\n", pS->nCells, pS->nCells);
+    printf("  Cells: %dx%d (%d per cutoff, stencil of %d)\n", pS->nCells, pS->nCells, pS->cellDivisions, pS->z);
     printf("  Cell size: %.2f\n", pS->cellSize);
     printf("  Cutoff radius: %.2f\n", pS->rc);
 }
 
 
-// Draw a filled circle at (x,y) with given radius
-void drawCircle(float x, float y, float radius) {
-    glBegin(GL_TRIANGLE_FAN);
-    glVertex2f(x, y);  // Circle center
-    int numSegments = NUM_SEGMENTS;
-    for (int i = 0; i <= numSegments; i++){
-        float theta = i * (2.0f * M_PI / numSegments);
-        float dx = radius * cos(theta);
-        float dy = radius * sin(theta);
-        glVertex2f(x + dx, y + dy);
-    }
-    glEnd();
-}
-
-
 // Draw the spatial partitioning cell grid
 void drawCellGrid() {
     glColor3f(0.7f, 0.7f, 0.7f);  // Light gray
@@ -379,25 +626,86 @@ void drawCellGrid() {
 }
 
 
-// Draw all particles as colored circles (red=infected, blue=susceptible)
-void drawParticlesAsCircles() {
-    int d = pS->d;
-    double L = L_BOX;
-    double r = PARTICLE_RADIUS;
-    
+// Draw all particles (red=infected, blue=susceptible) in a single draw call
+void drawParticlesAsCircles(const snapshot *sn) {
+    int d = DIM;
+    int vertices = (renderMode == RENDER_POINTS) ? 1 : CIRCLE_VERTICES;
+    float r = PARTICLE_RADIUS;
+
+    // Fill the vertex and color buffers from positions and states
     for (int i = 0; i < N; i++) {
-        double xc = pS->x[d * i + 0];
-        double yc = pS->x[d * i + 1];
-        int state = pS->state[i];
-        
-        if (state == 0)
-            glColor3f(1.0f, 0.2f, 0.2f);  // Red for infected
-        else
-            glColor3f(0.2f, 0.2f, 1.0f);  // Blue for susceptible
-        
-        // Draw particle at current position (no ghost copies for PBC)
-        drawCircle((float)xc, (float)yc, (float)r);
+        float xc = (float)sn->x[d * i + 0];
+        float yc = (float)sn->x[d * i + 1];
+        GLubyte red  = (sn->state[i] == 0) ? 255 : 51;
+        GLubyte blue = (sn->state[i] == 0) ? 51 : 255;
+
+        GLfloat *v = vertexBuffer + 2 * vertices * i;
+        GLubyte *c = colorBuffer + 3 * vertices * i;
+        for (int k = 0; k < vertices; k++) {
+            v[2 * k + 0] = xc + r * circleTemplate[2 * k + 0];
+            v[2 * k + 1] = yc + r * circleTemplate[2 * k + 1];
+            c[3 * k + 0] = red;
+            c[3 * k + 1] = 51;
+            c[3 * k + 2] = blue;
+        }
+    }
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, vertexBuffer);
+    glColorPointer(3, GL_UNSIGNED_BYTE, 0, colorBuffer);
+
+    if (renderMode == RENDER_POINTS) {
+        // Point diameter in pixels at the current zoom
+        float size = 2.0f * r * windowWidth / (zoomRight - zoomLeft);
+        glPointSize(size < 1.0f ? 1.0f : size);
+        glEnable(GL_POINT_SMOOTH);
+        glDrawArrays(GL_POINTS, 0, N);
+        glDisable(GL_POINT_SMOOTH);
+    } else {
+        glDrawElements(GL_TRIANGLES, CIRCLE_INDICES * N, GL_UNSIGNED_INT, indexBuffer);
+    }
+
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+
+// Count frames and draw the measured frame rate in the bottom-left corner
+void drawFPS(const snapshot *sn) {
+    frameCount++;
+    int time = glutGet(GLUT_ELAPSED_TIME);
+    if (time - frameTimeBase >= 1000) {
+        measuredFPS = frameCount * 1000.0 / (time - frameTimeBase);
+        frameTimeBase = time;
+        frameCount = 0;
+    }
+
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    gluOrtho2D(0, windowWidth, windowHeight, 0);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    char text[128];
+    int steps = atomic_load(&stepsPerFrame);
+    char spf[32];
+    if (steps > 0) snprintf(spf, sizeof(spf), "%d steps/frame", steps);
+    else           snprintf(spf, sizeof(spf), "full speed");
+    snprintf(text, sizeof(text), "%.1f FPS (%s), step %ld, %s", measuredFPS,
+             renderMode == RENDER_POINTS ? "points" : "circles", sn->step, spf);
+    glColor3f(0.0f, 0.0f, 0.0f);
+    glRasterPos2f(10.0f, windowHeight - 10.0f);
+    for (char* c = text; *c != '\0'; c++) {
+        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, *c);
     }
+
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
 }
 
 
@@ -413,11 +721,13 @@ void display_v00() {
         drawCellGrid();
     }
 
-    // Draw particles
-    drawParticlesAsCircles();
+    // Draw the latest snapshot published by the simulation thread
+    snapshot *sn = acquireSnapshot();
+    drawParticlesAsCircles(sn);
 
     // Draw UI on top
     drawUI();
+    drawFPS(sn);
 
     glutSwapBuffers();
 }
@@ -497,18 +807,8 @@ void adjustZoomInDirection(double deltaX, double deltaY) {
 }
 
 
-// Timer callback: update simulation and request redraw
+// Timer callback: request redraw (the simulation runs on its own thread)
 void update(int value){
-    // Update simulation if not paused
-    if(!pause){
-       iteration(pS);  // Update particle positions
-       
-       // Choose propagation model (uncomment one)
-       // propagation_v00(pS, 1.0, 0.5);  // Independent transitions
-       // propagation_v01(pS, 1.0, 0.5);  // Count-based infection
-       propagation_v02(pS, currentBeta, currentLambda);  // Distance-dependent infection (using current values)
-    }
-
     // Request redraw
     glutPostRedisplay();
 
@@ -536,15 +836,16 @@ void mouse(int button, int state, int x, int y) {
         double simX = zoomLeft + ((double)x / windowWidth) * (zoomRight - zoomLeft);
         double simY = zoomTop - ((double)y / windowHeight) * (zoomTop - zoomBottom);
         
-        // Find closest particle within click radius
-        int d = pS->d;
+        // Find closest particle within click radius in the displayed snapshot
+        const snapshot *sn = &snapshots[frontSnapshot];
+        int d = DIM;
         double clickRadius = 1.0;  // Detection radius in simulation units
         double minDist = clickRadius;
         int closestParticle = -1;
         
         for (int i = 0; i < N; i++) {
-            double px = pS->x[d * i + 0];
-            double py = pS->x[d * i + 1];
+            double px = sn->x[d * i + 0];
+            double py = sn->x[d * i + 1];
             
             // Calculate distance to click
             double dx = px - simX;
@@ -557,10 +858,12 @@ void mouse(int button, int state, int x, int y) {
             }
         }
         
-        // Infect the closest particle if found
+        // Infect the closest particle if found, by label: its slot may have
+        // moved by the time the command runs
         if (closestParticle >= 0) {
-            pS->state[closestParticle] = 0;  // 0 = infected
-            printf("Particle %d infected! (distance: %.2f)\n", closestParticle, minDist);
+            int label = sn->index[closestParticle];
+            pushCommand(CMD_INFECT, label, 0.0);
+            printf("Particle %d infected! (distance: %.2f)\n", label, minDist);
             glutPostRedisplay();
         }
     }
@@ -571,6 +874,8 @@ void mouse(int button, int state, int x, int y) {
 void keyboard(unsigned char key, int x, int y) {
     switch (key) {
         case 27: // ESC: exit program
+            stopSimulation();
+            destroyRenderBuffers();
             destroySystem(pS);
             exit(0);
             break;
@@ -610,7 +915,7 @@ void keyboard(unsigned char key, int x, int y) {
             break;
 
         case 'p': case 'P': // Pause/resume
-            pause = !pause;
+            atomic_store(&paused, !atomic_load(&paused));
             break;
 
         case 'g': case 'G': // Toggle grid view
@@ -621,18 +926,33 @@ void keyboard(unsigned char key, int x, int y) {
             showUI = !showUI;
             break;
 
+        case 'c': case 'C': // Toggle circles/points rendering
+            renderMode = (renderMode == RENDER_CIRCLES) ? RENDER_POINTS : RENDER_CIRCLES;
+            break;
+
         case 'd': case 'D':
-            resetInfection(pS);
+            pushCommand(CMD_RESET_INFECTION, 0, 0.0);
             break;
         
         case 'e': case 'E':
             unifSigma = !unifSigma;
-            (unifSigma)? uniformSigma(pS, currentSigma) : randomGaussianSigma(pS, currentSigma); 
+            pushCommand(CMD_SIGMA, !unifSigma, currentSigma);
             break;
 
         case 'a': case 'A':
             unifAlpha = !unifAlpha;
-            (unifAlpha)? uniformAlpha(pS, currentAlpha) : randomGaussianAlpha(pS, currentAlpha); 
+            pushCommand(CMD_ALPHA, !unifAlpha, currentAlpha);
+            break;
+
+        case 's': // More steps per frame
+            atomic_store(&stepsPerFrame, atomic_load(&stepsPerFrame) + 1);
+            printf("Steps per frame: %d\n", atomic_load(&stepsPerFrame));
+            break;
+
+        case 'S': // Fewer steps per frame (0 = full speed)
+            if (atomic_load(&stepsPerFrame) > 0)
+                atomic_store(&stepsPerFrame, atomic_load(&stepsPerFrame) - 1);
+            printf("Steps per frame: %d\n", atomic_load(&stepsPerFrame));
             break;
 
         default:
@@ -667,6 +987,25 @@ void specialKeys(int key, int x, int y) {
 int main(int argc, char **argv) {
 
     glutInit(&argc, argv);
+
+    // Options left after GLUT removed its own
+    const char *kernelName = "v02";
+    int opt;
+    while ((opt = getopt(argc, argv, "v:")) != -1) {
+        switch (opt) {
+            case 'v': kernelName = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-v kernel]\n", argv[0]);
+                return 1;
+        }
+    }
+    kernel = findKernel(kernelName);
+    if (kernel == NULL) {
+        fprintf(stderr, "Unknown kernel: %s. Kernels:\n", kernelName);
+        printKernels(stderr);
+        return 1;
+    }
+
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB);
     glutInitWindowSize(windowWidth, windowHeight);
     glutCreateWindow("SIS Epidemic Model");
@@ -682,6 +1021,7 @@ int main(int argc, char **argv) {
     glutTimerFunc(1000 / FPS, update, 0);
 
     // Print controls
+    printf("\nKernel: %s (%s)\n", kernel->name, kernel->description);
     printf("\n=== CONTROLS ===\n");
     printf("ESC: Exit\n");
     printf("+/-: Zoom in/out\n");
@@ -689,7 +1029,9 @@ int main(int argc, char **argv) {
     printf("p: Pause/resume\n");
     printf("g: Toggle grid view\n");
     printf("u: Toggle UI panel\n");
+    printf("c: Toggle circles/points rendering\n");
     printf("f/F: Increase/decrease FPS\n");
+    printf("s/S: Increase/decrease steps per frame (0 = full speed)\n");
     printf("Arrows: Pan view\n");
     printf("\nUI BUTTONS:\n");
     printf("A-/A+: Decrease/Increase Alpha\n");
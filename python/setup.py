@@ -0,0 +1,39 @@
+#!/usr/bin/env python3
+"""
+Build the simodel extension from the engine sources.
+
+Compile-time parameters are read from the environment, as in the run_*.sh
+scripts (PHI, RC, N, ALPHA, SIGMA, DT, BETA, LAMBDA); EXTRA_CFLAGS is
+appended (e.g. -DSINGLE_PRECISION). Asserts stay enabled (-UNDEBUG), as in
+the C programs. Usually called through run_python.sh.
+"""
+
+import os
+import shlex
+from setuptools import setup, Extension
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(HERE)
+
+PARAMETERS = ['PHI', 'RC', 'N', 'ALPHA', 'SIGMA', 'DT', 'BETA', 'LAMBDA']
+macros = [(p, os.environ[p]) for p in PARAMETERS if os.environ.get(p)]
+
+sources = [os.path.join(HERE, 'simodel.c')] + [
+    os.path.join(ROOT, 'src', f) for f in ('system.c', 'recorder.c', 'offspring.c', 'random.c', 'instrument.c')
+]
+
+simodel = Extension(
+    'simodel',
+    sources=sources,
+    include_dirs=[os.path.join(ROOT, 'include')],
+    define_macros=macros,
+    extra_compile_args=['-O2', '-UNDEBUG'] + shlex.split(os.environ.get('EXTRA_CFLAGS', '')),
+    libraries=['m', 'pthread'],
+)
+
+setup(
+    name='simodel',
+    version='0.1',
+    description='SIS epidemic engine with zero-copy NumPy views',
+    ext_modules=[simodel],
+)
@@ -0,0 +1,453 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "config.h"
+#include "random.h"
+#include "system.h"
+
+// =======================================================
+//   Python interface to the SIS engine
+// =======================================================
+//
+// simodel.System wraps one systemSI. Its arrays (x, x0, state, flag, alpha,
+// sigma, index) are returned as NumPy arrays that alias engine memory: writes
+// from Python are seen by the engine and every step updates the arrays in
+// place. alpha and sigma are read-only: the engine integrates with the
+// per-class coefficients, so they change only through the setters.
+// They stay valid while the System is alive (each array holds a reference
+// to it). Compile-time parameters (N, PHI, ...) are fixed when the module is
+// built, as for the C programs (see python/setup.py).
+
+// Kernel by name, with a Python exception if unknown
+static const kernelInfo *lookupKernel(const char *name) {
+    const kernelInfo *e = findKernel(name);
+    if (e == NULL) PyErr_Format(PyExc_ValueError, "unknown kernel '%s'", name);
+    return e;
+}
+
+
+// =======================================================
+//   EngineArray: buffer over one engine array
+// =======================================================
+
+typedef struct {
+    PyObject_HEAD
+    PyObject *owner;           // System that owns the memory
+    void *data;
+    int ndim;
+    Py_ssize_t shape[2];
+    Py_ssize_t strides[2];
+    Py_ssize_t itemsize;
+    char *format;
+    int readonly;              // Engine ignores writes (alpha, sigma)
+} EngineArray;
+
+
+static int EngineArray_getbuffer(EngineArray *self, Py_buffer *view, int flags) {
+    if (self->readonly && (flags & PyBUF_WRITABLE)) {
+        PyErr_SetString(PyExc_BufferError, "array is read-only (use the setters)");
+        return -1;
+    }
+    Py_ssize_t len = self->itemsize;
+    for (int k = 0; k < self->ndim; k++) len *= self->shape[k];
+
+    view->obj = (PyObject *)self;
+    Py_INCREF(self);
+    view->buf = self->data;
+    view->len = len;
+    view->readonly = self->readonly;
+    view->itemsize = self->itemsize;
+    view->format = (flags & PyBUF_FORMAT) ? self->format : NULL;
+    view->ndim = self->ndim;
+    view->shape = (flags & PyBUF_ND) ? self->shape : NULL;
+    view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? self->strides : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    return 0;
+}
+
+
+static void EngineArray_dealloc(EngineArray *self) {
+    Py_XDECREF(self->owner);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+
+static PyBufferProcs EngineArray_as_buffer = {
+    (getbufferproc)EngineArray_getbuffer,
+    NULL,
+};
+
+static PyTypeObject EngineArrayType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "simodel.EngineArray",
+    .tp_basicsize = sizeof(EngineArray),
+    .tp_dealloc = (destructor)EngineArray_dealloc,
+    .tp_as_buffer = &EngineArray_as_buffer,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "Buffer aliasing one array of a simodel.System",
+};
+
+
+// numpy.asarray, or None if NumPy is not installed (arrays are then memoryviews)
+static PyObject *asarray = NULL;
+
+
+// Wrap engine memory as an (n, cols) or (n,) array without copying
+static PyObject *wrapArray(PyObject *owner, void *data, Py_ssize_t n, Py_ssize_t cols,
+                           Py_ssize_t itemsize, char *format, int readonly) {
+    EngineArray *a = PyObject_New(EngineArray, &EngineArrayType);
+    if (a == NULL) return NULL;
+
+    Py_INCREF(owner);
+    a->owner = owner;
+    a->data = data;
+    a->itemsize = itemsize;
+    a->format = format;
+    a->readonly = readonly;
+    a->ndim = (cols > 1) ? 2 : 1;
+    a->shape[0] = n;
+    a->shape[1] = cols;
+    a->strides[0] = cols * itemsize;
+    a->strides[1] = itemsize;
+
+    PyObject *result = (asarray != Py_None) ? PyObject_CallOneArg(asarray, (PyObject *)a)
+                                            : PyMemoryView_FromObject((PyObject *)a);
+    Py_DECREF(a);
+    return result;
+}
+
+
+// =======================================================
+//   System
+// =======================================================
+
+typedef struct {
+    PyObject_HEAD
+    systemSI *pS;
+} System;
+
+#define REAL_FORMAT (sizeof(real) == sizeof(float) ? "f" : "d")
+
+
+static int System_init(System *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"rc", "dt", "alpha", "sigma", "seed", NULL};
+    double rc = RC, dt = DT, alpha = ALPHA, sigma = SIGMA;
+    unsigned int seed = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|ddddI", kwlist, &rc, &dt, &alpha, &sigma, &seed))
+        return -1;
+
+    // Arrays handed out earlier alias the current arena
+    if (self->pS != NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "System is already initialized (create a new one)");
+        return -1;
+    }
+    seed_random(seed);
+    self->pS = makeSystem(rc, dt, alpha, sigma, DIM, COORDINATION);
+    return 0;
+}
+
+
+// The engine system, or a RuntimeError if __init__ did not run
+static systemSI *systemOf(System *self) {
+    if (self->pS == NULL) PyErr_SetString(PyExc_RuntimeError, "System is not initialized");
+    return self->pS;
+}
+
+
+static void System_dealloc(System *self) {
+    if (self->pS != NULL) destroySystem(self->pS);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+
+// States may have been written through the state array: redraw the
+// recovery schedule if it no longer matches them
+static void syncRecoveries(systemSI *pS) {
+    for (int i = 0; i < N; i++) {
+        if ((pS->state[i] == 0) != (pS->wheel.recoverAt[i] >= 0)) {
+            pS->wheel.dirty = 1;
+            return;
+        }
+    }
+}
+
+
+// Engine calls keep the GIL: the random number generator (random.c) is
+// shared by every System, and methods of one System must not overlap
+
+// Advance n steps: iteration() plus the chosen propagation kernel
+static PyObject *System_step(System *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"n", "kernel", "beta", "lambda_", NULL};
+    long n = 1;
+    const char *kernelName = "v02";
+    double beta = BETA, lambda = LAMBDA;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|lsdd", kwlist, &n, &kernelName, &beta, &lambda))
+        return NULL;
+    const kernelInfo *e = lookupKernel(kernelName);
+    if (e == NULL) return NULL;
+
+    systemSI *pS = systemOf(self);
+    if (pS == NULL) return NULL;
+    int result = 0;
+    syncRecoveries(pS);
+    for (long k = 0; k < n; k++) {
+        iteration(pS);
+        result = e->run(pS, beta, lambda);
+    }
+
+    // Infected count, or the value returned by v03/v04
+    if (e->count == COUNT_NONE)
+        for (int i = 0; i < N; i++) result += (pS->state[i] == 0);
+    return PyLong_FromLong(result);
+}
+
+
+// Run propagation_v04 until idx0 recovers, as one realization of meassure
+static PyObject *System_measure_r0(System *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"beta", "lambda_", "max_steps", NULL};
+    double beta = BETA, lambda = LAMBDA;
+    long maxSteps = 10000;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|ddl", kwlist, &beta, &lambda, &maxSteps))
+        return NULL;
+
+    systemSI *pS = systemOf(self);
+    if (pS == NULL) return NULL;
+    long step;
+    syncRecoveries(pS);
+    int r0 = measureR0(pS, beta, lambda, maxSteps, &step);
+
+    return Py_BuildValue("(li)", step, r0);
+}
+
+
+static PyObject *System_reset(System *self, PyObject *Py_UNUSED(ignored)) {
+    systemSI *pS = systemOf(self);
+    if (pS == NULL) return NULL;
+    resetSystem(pS);
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *System_relax(System *self, PyObject *Py_UNUSED(ignored)) {
+    systemSI *pS = systemOf(self);
+    if (pS == NULL) return NULL;
+    relaxParticles(pS);
+    getCellIndex(pS);
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *System_initial_state(System *self, PyObject *Py_UNUSED(ignored)) {
+    systemSI *pS = systemOf(self);
+    if (pS == NULL) return NULL;
+    initialState(pS);
+    Py_RETURN_NONE;
+}
+
+
+// Parameter setters: one value for all particles, or Gaussian mobility
+// classes (mean >= 0, see randomGaussianSigma)
+#define SETTER(name, function, gaussian)                                 \
+    static PyObject *System_##name(System *self, PyObject *arg) {        \
+        systemSI *pS = systemOf(self);                                   \
+        if (pS == NULL) return NULL;                                     \
+        double value = PyFloat_AsDouble(arg);                            \
+        if (value == -1.0 && PyErr_Occurred()) return NULL;              \
+        if (gaussian && !(value >= 0.0)) {                               \
+            PyErr_SetString(PyExc_ValueError, "mean must be >= 0");     \
+            return NULL;                                                 \
+        }                                                                \
+        function(pS, value);                                             \
+        Py_RETURN_NONE;                                                  \
+    }
+
+SETTER(uniform_alpha, uniformAlpha, 0)
+SETTER(uniform_sigma, uniformSigma, 0)
+SETTER(gaussian_alpha, randomGaussianAlpha, 1)
+SETTER(gaussian_sigma, randomGaussianSigma, 1)
+
+
+static PyObject *System_get_x(System *self, void *closure) {
+    systemSI *pS = systemOf(self);
+    if (pS == NULL) return NULL;
+    return wrapArray((PyObject *)self, pS->x, N, pS->d, sizeof(real), REAL_FORMAT, 0);
+}
+
+static PyObject *System_get_x0(System *self, void *closure) {
+    systemSI *pS = systemOf(self);
+    if (pS == NULL) return NULL;
+    return wrapArray((PyObject *)self, pS->x0, N, pS->d, sizeof(real), REAL_FORMAT, 0);
+}
+
+static PyObject *System_get_alpha(System *self, void *closure) {
+    systemSI *pS = systemOf(self);
+    if (pS == NULL) return NULL;
+    return wrapArray((PyObject *)self, pS->alpha, N, 1, sizeof(real), REAL_FORMAT, 1);
+}
+
+static PyObject *System_get_sigma(System *self, void *closure) {
+    systemSI *pS = systemOf(self);
+    if (pS == NULL) return NULL;
+    return wrapArray((PyObject *)self, pS->sigma, N, 1, sizeof(real), REAL_FORMAT, 1);
+}
+
+static PyObject *System_get_state(System *self, void *closure) {
+    systemSI *pS = systemOf(self);
+    if (pS == NULL) return NULL;
+    return wrapArray((PyObject *)self, pS->state, N, 1, sizeof(int), "i", 0);
+}
+
+static PyObject *System_get_flag(System *self, void *closure) {
+    systemSI *pS = systemOf(self);
+    if (pS == NULL) return NULL;
+    return wrapArray((PyObject *)self, pS->flag, N, 1, sizeof(int), "i", 0);
+}
+
+static PyObject *System_get_index(System *self, void *closure) {
+    systemSI *pS = systemOf(self);
+    if (pS == NULL) return NULL;
+    return wrapArray((PyObject *)self, pS->index, N, 1, sizeof(int), "i", 0);
+}
+
+static PyObject *System_get_step(System *self, void *closure) {
+    systemSI *pS = systemOf(self);
+    if (pS == NULL) return NULL;
+    return PyLong_FromLong(pS->step);
+}
+
+static PyObject *System_get_idx0(System *self, void *closure) {
+    systemSI *pS = systemOf(self);
+    if (pS == NULL) return NULL;
+    return PyLong_FromLong(pS->idx0);
+}
+
+static PyObject *System_get_dt(System *self, void *closure) {
+    systemSI *pS = systemOf(self);
+    if (pS == NULL) return NULL;
+    return PyFloat_FromDouble(pS->dt);
+}
+
+static PyObject *System_get_rc(System *self, void *closure) {
+    systemSI *pS = systemOf(self);
+    if (pS == NULL) return NULL;
+    return PyFloat_FromDouble(pS->rc);
+}
+
+
+static PyMethodDef System_methods[] = {
+    {"step", (PyCFunction)(void (*)(void))System_step, METH_VARARGS | METH_KEYWORDS,
+     "step(n=1, kernel='v02', beta=BETA, lambda_=LAMBDA) -> infected count\n"
+     "Advance n steps (iteration + propagation). v03/v04 return their own count."},
+    {"measure_r0", (PyCFunction)(void (*)(void))System_measure_r0, METH_VARARGS | METH_KEYWORDS,
+     "measure_r0(beta=BETA, lambda_=LAMBDA, max_steps=10000) -> (steps, r0)\n"
+     "Run propagation_v04 until idx0 recovers; r0 is the value meassure prints."},
+    {"reset", (PyCFunction)System_reset, METH_NOARGS,
+     "New equilibrium and stationary positions, one random infected, step = 0."},
+    {"relax", (PyCFunction)System_relax, METH_NOARGS,
+     "Fresh stationary draw of x around the current x0."},
+    {"initial_state", (PyCFunction)System_initial_state, METH_NOARGS,
+     "All susceptible except one random infected particle (idx0)."},
+    {"uniform_alpha", (PyCFunction)System_uniform_alpha, METH_O, "Set alpha for all particles."},
+    {"uniform_sigma", (PyCFunction)System_uniform_sigma, METH_O, "Set sigma for all particles."},
+    {"gaussian_alpha", (PyCFunction)System_gaussian_alpha, METH_O,
+     "Quantized positive Gaussian alpha (mean >= 0 given); particles are regrouped."},
+    {"gaussian_sigma", (PyCFunction)System_gaussian_sigma, METH_O,
+     "Quantized positive Gaussian sigma (mean >= 0 given); particles are regrouped."},
+    {NULL}
+};
+
+static PyGetSetDef System_getset[] = {
+    {"x", (getter)System_get_x, NULL, "Positions (N, d), aliasing engine memory", NULL},
+    {"x0", (getter)System_get_x0, NULL, "Equilibrium positions (N, d)", NULL},
+    {"alpha", (getter)System_get_alpha, NULL, "Per-particle alpha (N,), read-only (set with uniform_/gaussian_alpha)", NULL},
+    {"sigma", (getter)System_get_sigma, NULL, "Per-particle sigma (N,), read-only (set with uniform_/gaussian_sigma)", NULL},
+    {"state", (getter)System_get_state, NULL, "States (N,): 0 infected, 1 susceptible", NULL},
+    {"flag", (getter)System_get_flag, NULL, "Ever infected (N,), maintained by v04", NULL},
+    {"index", (getter)System_get_index, NULL, "Original label of each slot (N,)", NULL},
+    {"step_count", (getter)System_get_step, NULL, "Completed integration steps", NULL},
+    {"idx0", (getter)System_get_idx0, NULL, "Slot of the first infected particle", NULL},
+    {"dt", (getter)System_get_dt, NULL, "Time step", NULL},
+    {"rc", (getter)System_get_rc, NULL, "Cutoff radius", NULL},
+    {NULL}
+};
+
+static PyTypeObject SystemType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "simodel.System",
+    .tp_basicsize = sizeof(System),
+    .tp_dealloc = (destructor)System_dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "System(rc=RC, dt=DT, alpha=ALPHA, sigma=SIGMA, seed=0): one SIS system",
+    .tp_methods = System_methods,
+    .tp_getset = System_getset,
+    .tp_init = (initproc)System_init,
+    .tp_new = PyType_GenericNew,
+};
+
+
+// =======================================================
+//   Module
+// =======================================================
+
+static PyObject *simodel_seed(PyObject *self, PyObject *arg) {
+    unsigned long seed = PyLong_AsUnsignedLong(arg);
+    if (seed == (unsigned long)-1 && PyErr_Occurred()) return NULL;
+    seed_random((unsigned int)seed);
+    Py_RETURN_NONE;
+}
+
+
+static PyMethodDef simodel_methods[] = {
+    {"seed", simodel_seed, METH_O, "Seed the engine RNG (0 uses time)."},
+    {NULL}
+};
+
+static struct PyModuleDef simodelModule = {
+    PyModuleDef_HEAD_INIT,
+    .m_name = "simodel",
+    .m_doc = "SIS epidemic engine with zero-copy NumPy views of its arrays.",
+    .m_size = -1,
+    .m_methods = simodel_methods,
+};
+
+
+PyMODINIT_FUNC PyInit_simodel(void) {
+    if (PyType_Ready(&EngineArrayType) < 0 || PyType_Ready(&SystemType) < 0)
+        return NULL;
+
+    PyObject *m = PyModule_Create(&simodelModule);
+    if (m == NULL) return NULL;
+
+    // Arrays are NumPy arrays if NumPy is available, memoryviews otherwise
+    PyObject *numpy = PyImport_ImportModule("numpy");
+    if (numpy != NULL) {
+        asarray = PyObject_GetAttrString(numpy, "asarray");
+        Py_DECREF(numpy);
+    }
+    if (asarray == NULL) {
+        PyErr_Clear();
+        asarray = Py_None;
+        Py_INCREF(asarray);
+    }
+
+    Py_INCREF(&SystemType);
+    PyModule_AddObject(m, "System", (PyObject *)&SystemType);
+
+    // Compile-time parameters
+    PyModule_AddIntConstant(m, "N", N);
+    PyModule_AddIntConstant(m, "DIM", DIM);
+    PyModule_AddObject(m, "PHI", PyFloat_FromDouble(PHI));
+    PyModule_AddObject(m, "L_BOX", PyFloat_FromDouble(L_BOX));
+    PyModule_AddObject(m, "RC", PyFloat_FromDouble(RC));
+    PyModule_AddObject(m, "DT", PyFloat_FromDouble(DT));
+    PyModule_AddObject(m, "ALPHA", PyFloat_FromDouble(ALPHA));
+    PyModule_AddObject(m, "SIGMA", PyFloat_FromDouble(SIGMA));
+    PyModule_AddObject(m, "BETA", PyFloat_FromDouble(BETA));
+    PyModule_AddObject(m, "LAMBDA", PyFloat_FromDouble(LAMBDA));
+
+    return m;
+}
@@ -0,0 +1,51 @@
+#!/bin/bash
+
+# =======================================================
+# Build and run the kernel microbenchmarks over a parameter grid
+# =======================================================
+#
+# N, PHI and RC are compile-time parameters, so the benchmark is rebuilt for
+# every grid point. The infected fractions are swept inside each run.
+# Results are written to stdout as one JSON array.
+
+# Parameter grid (override via environment)
+N_LIST=${N_LIST:-"1000 10000"}
+PHI_LIST=${PHI_LIST:-"0.5 0.9"}
+RC_LIST=${RC_LIST:-"1.5 2.5"}
+FRACTIONS=${FRACTIONS:-"0.01 0.1 0.5"}
+STEPS=${1:-200}         # Steps per measurement
+SEED=${2:-1}            # Random seed
+
+# Compiler settings
+GCC=gcc
+OPT=${OPT:-"-O2"}
+LDFLAGS="-lm -lpthread"
+
+# Source files and output
+SRC="bench.c src/system.c src/recorder.c src/offspring.c src/random.c src/instrument.c"
+OUT="bench"
+
+echo "# Benchmark grid: N=[${N_LIST}] PHI=[${PHI_LIST}] RC=[${RC_LIST}] fractions=[${FRACTIONS}]" >&2
+
+FIRST=1
+echo "["
+for N in $N_LIST; do
+    for PHI in $PHI_LIST; do
+        for RC in $RC_LIST; do
+            CFLAGS="$OPT -Iinclude -DPHI=${PHI} -DRC=${RC} -DN=${N}"
+            echo "# Compiling N=${N} PHI=${PHI} RC=${RC}..." >&2
+            $GCC $CFLAGS $SRC $LDFLAGS -o $OUT || {
+                echo "# Compilation failed!" >&2
+                exit 1
+            }
+
+            echo "# Running..." >&2
+            while read -r LINE; do
+                if [ $FIRST -eq 1 ]; then FIRST=0; else echo ","; fi
+                echo -n "  $LINE"
+            done < <(./$OUT -n $STEPS -s $SEED $FRACTIONS)
+        done
+    done
+done
+echo ""
+echo "]"
@@ -0,0 +1,30 @@
+#!/bin/bash
+
+# =======================================================
+# Compilation script for the density field converter
+# =======================================================
+
+# Compiler settings
+GCC=gcc
+CFLAGS="-Iinclude"
+LDFLAGS="-lm -lpthread"
+
+# Source files and output
+SRC="density2dat.c src/density.c"
+OUT="density2dat"
+
+# Compile
+echo "$GCC $CFLAGS $SRC $LDFLAGS -o $OUT"
+$GCC $CFLAGS $SRC $LDFLAGS -o $OUT
+
+# Check compilation result
+if [ $? -eq 0 ]; then
+    echo ""
+    echo "# Compilation successful."
+    echo "# List frames: ./$OUT fields.bin"
+    echo "# One frame:   ./$OUT fields.bin 10 > frame10.dat"
+else
+    echo ""
+    echo "# Compilation error."
+    exit 1
+fi
@@ -0,0 +1,30 @@
+#!/bin/bash
+
+# =======================================================
+# Compilation script for the event converter
+# =======================================================
+
+# Compiler settings
+GCC=gcc
+CFLAGS="-Iinclude"
+LDFLAGS="-lm -lpthread"
+
+# Source files and output
+SRC="events2dat.c src/recorder.c"
+OUT="events2dat"
+
+# Compile
+echo "$GCC $CFLAGS $SRC $LDFLAGS -o $OUT"
+$GCC $CFLAGS $SRC $LDFLAGS -o $OUT
+
+# Check compilation result
+if [ $? -eq 0 ]; then
+    echo ""
+    echo "# Compilation successful."
+    echo "# Dump events: ./$OUT events.bin > events.dat"
+    echo "# Count:       ./$OUT events.bin count"
+else
+    echo ""
+    echo "# Compilation error."
+    exit 1
+fi
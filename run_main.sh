@@ -14,13 +14,13 @@ DT=${6:-0.01}      # Time step
 BETA=${7:-0.5}     # Recovery rate (I -> S)
 LAMBDA=${8:-1.0}   # Spatial decay of infection
 
-# Compiler settings
+# Compiler settings (EXTRA_CFLAGS, e.g. -DINSTRUMENT, is appended)
 GCC=gcc
-CFLAGS="-Iinclude -DPHI=${PHI} -DRC=${RC} -DN=${N} -DALPHA=${ALPHA} -DSIGMA=${SIGMA} -DDT=${DT} -DBETA=${BETA} -DLAMBDA=${LAMBDA}"
-LDFLAGS="-lm"
+CFLAGS="-Iinclude -DPHI=${PHI} -DRC=${RC} -DN=${N} -DALPHA=${ALPHA} -DSIGMA=${SIGMA} -DDT=${DT} -DBETA=${BETA} -DLAMBDA=${LAMBDA} ${EXTRA_CFLAGS}"
+LDFLAGS="-lm -lpthread"
 
 # Source files and output
-SRC="main.c src/system.c src/random.c"
+SRC="main.c src/system.c src/recorder.c src/offspring.c src/random.c src/instrument.c src/checkpoint.c src/trajectory.c src/observables.c src/density.c src/numa.c"
 OUT="main"
 
 # Display compilation parameters
@@ -15,13 +15,13 @@ BETA=${7:-1.0}     # Recovery rate (I -> S)
 LAMBDA=${8:-1.0}   # Spatial decay of infection
 REALIZ=${9:-1000}  # Number of realizations per sigma
 
-# Compiler settings
+# Compiler settings (EXTRA_CFLAGS, e.g. -DINSTRUMENT, is appended)
 GCC=gcc
-CFLAGS="-Iinclude -DPHI=${PHI} -DRC=${RC} -DN=${N} -DALPHA=${ALPHA} -DSIGMA=${SIGMA} -DDT=${DT} -DBETA=${BETA} -DLAMBDA=${LAMBDA} -DREALIZATION=${REALIZ}"
-LDFLAGS="-lm"
+CFLAGS="-Iinclude -DPHI=${PHI} -DRC=${RC} -DN=${N} -DALPHA=${ALPHA} -DSIGMA=${SIGMA} -DDT=${DT} -DBETA=${BETA} -DLAMBDA=${LAMBDA} -DREALIZATION=${REALIZ} ${EXTRA_CFLAGS}"
+LDFLAGS="-lm -lpthread"
 
 # Source files and output
-SRC="meassure.c src/system.c src/random.c"
+SRC="meassure.c src/system.c src/recorder.c src/offspring.c src/random.c src/instrument.c src/checkpoint.c"
 OUT="meassure"
 
 # Display compilation parameters
@@ -0,0 +1,46 @@
+#!/bin/bash
+
+# =======================================================
+# Accuracy check of the single precision build
+# =======================================================
+#
+# Usage: ./run_precision_check.sh [KERNEL] [SEEDS] [STEPS] [BETA] [LAMBDA]
+# Runs KERNEL in a double build, saves its samples, then runs the same kernel
+# with independent seeds in a -DSINGLE_PRECISION build and compares both with
+# the validate tests. Exit status is 0 if the float build passes.
+
+# Kernel and run lengths
+KERNEL=${1:-v04}        # Kernel to check (v04 also compares R0)
+SEEDS=${2:-400}         # Realizations per build
+STEPS=${3:-1000}        # Maximum steps per realization
+BETA=${4:-0.5}          # Recovery rate (I -> S)
+LAMBDA=${5:-1.0}        # Spatial decay of infection
+
+# Small system (compile-time parameters)
+PHI=${PHI:-0.9}
+RC=${RC:-2.5}
+N=${N:-200}
+ALPHA=${ALPHA:-1.0}
+SIGMA=${SIGMA:-0.5}
+DT=${DT:-0.01}
+
+# Compiler settings (EXTRA_CFLAGS is appended)
+GCC=gcc
+CFLAGS="-O2 -Iinclude -DPHI=${PHI} -DRC=${RC} -DN=${N} -DALPHA=${ALPHA} -DSIGMA=${SIGMA} -DDT=${DT} ${EXTRA_CFLAGS}"
+LDFLAGS="-lm -lpthread"
+
+# Source files, outputs and samples of the double build
+SRC="validate.c src/system.c src/recorder.c src/offspring.c src/random.c src/instrument.c src/stats.c"
+SAMPLES="precision_double.dat"
+
+echo "$GCC $CFLAGS $SRC $LDFLAGS -o validate_double"
+$GCC $CFLAGS $SRC $LDFLAGS -o validate_double || exit 2
+echo "$GCC $CFLAGS -DSINGLE_PRECISION $SRC $LDFLAGS -o validate_single"
+$GCC $CFLAGS -DSINGLE_PRECISION $SRC $LDFLAGS -o validate_single || exit 2
+
+# Double precision reference samples
+./validate_double -r $KERNEL -c $KERNEL -n $SEEDS -m $STEPS -b $BETA -l $LAMBDA -s 1 -w $SAMPLES > /dev/null
+[ -f $SAMPLES ] || exit 2
+
+# Single precision with independent seeds against the saved samples
+./validate_single -r $KERNEL -c $KERNEL -n $SEEDS -m $STEPS -b $BETA -l $LAMBDA -s $((2 * SEEDS + 1)) -x $SAMPLES
@@ -0,0 +1,45 @@
+#!/bin/bash
+
+# =======================================================
+# Build the simodel Python extension
+# =======================================================
+
+# System parameters (with default values)
+export PHI=${1:-0.9}      # Particle density
+export RC=${2:-2.5}       # Cutoff radius for interactions
+export N=${3:-1000}       # Number of particles
+export ALPHA=${4:-1.0}    # OU process relaxation rate
+export SIGMA=${5:-0.5}    # OU process noise strength
+export DT=${6:-0.01}      # Time step
+export BETA=${7:-0.5}     # Recovery rate (I -> S)
+export LAMBDA=${8:-1.0}   # Spatial decay of infection
+
+# Python interpreter (EXTRA_CFLAGS, e.g. -DSINGLE_PRECISION, is passed through)
+PYTHON=${PYTHON:-python3}
+
+# Display compilation parameters
+echo "# =========================================="
+echo "# Compilation parameters:"
+echo "# PHI    = ${PHI}    (density)"
+echo "# RC     = ${RC}     (cutoff radius)"
+echo "# N      = ${N}      (particles)"
+echo "# ALPHA  = ${ALPHA}  (OU relaxation)"
+echo "# SIGMA  = ${SIGMA}  (OU noise)"
+echo "# DT     = ${DT}     (time step)"
+echo "# BETA   = ${BETA}   (recovery rate)"
+echo "# LAMBDA = ${LAMBDA} (infection decay)"
+echo "# =========================================="
+echo ""
+
+# Build in place: the module lands in python/
+cd python && $PYTHON setup.py build_ext --inplace
+
+# Check compilation result
+if [ $? -eq 0 ]; then
+    echo ""
+    echo "# Compilation successful. Use with: PYTHONPATH=python python3 -c 'import simodel'"
+else
+    echo ""
+    echo "# Compilation error."
+    exit 1
+fi
@@ -0,0 +1,60 @@
+#!/bin/bash
+
+# =======================================================
+# Compilation script for the adaptive threshold search
+# =======================================================
+
+# System parameters (with default values, as full_R0_simulation.sh);
+# the searched parameter (sigma or lambda) is set at runtime
+PHI=${1:-0.9}      # Particle density
+RC=${2:-2.5}       # Cutoff radius for interactions
+N=${3:-1000}       # Number of particles
+ALPHA=${4:-1.0}    # OU process relaxation rate
+SIGMA=${5:-0.5}    # OU process noise strength (when searching lambda)
+DT=${6:-0.01}      # Time step
+BETA=${7:-0.2}     # Recovery rate (I -> S)
+LAMBDA=${8:-2.0}   # Spatial decay of infection (when searching sigma)
+
+# Compiler settings (EXTRA_CFLAGS is appended)
+GCC=gcc
+CFLAGS="-O2 -Iinclude -DPHI=${PHI} -DRC=${RC} -DN=${N} -DALPHA=${ALPHA} -DSIGMA=${SIGMA} -DDT=${DT} -DBETA=${BETA} -DLAMBDA=${LAMBDA} ${EXTRA_CFLAGS}"
+LDFLAGS="-lm -lpthread"
+
+# Source files and output
+SRC="threshold.c src/system.c src/recorder.c src/offspring.c src/random.c src/instrument.c"
+OUT="threshold"
+
+# Display compilation parameters
+echo "# =========================================="
+echo "# Compilation parameters:"
+echo "# PHI    = ${PHI}    (density)"
+echo "# RC     = ${RC}     (cutoff radius)"
+echo "# N      = ${N}      (particles)"
+echo "# ALPHA  = ${ALPHA}  (OU relaxation)"
+echo "# SIGMA  = ${SIGMA}  (OU noise)"
+echo "# DT     = ${DT}     (time step)"
+echo "# BETA   = ${BETA}   (recovery rate)"
+echo "# LAMBDA = ${LAMBDA} (infection decay)"
+echo "# =========================================="
+echo ""
+
+# Compile
+echo "# Compiling..."
+echo "$GCC $CFLAGS $SRC $LDFLAGS -o $OUT"
+$GCC $CFLAGS $SRC $LDFLAGS -o $OUT
+
+# Check compilation result
+if [ $? -eq 0 ]; then
+    echo ""
+    echo "# =========================================="
+    echo "# Compilation successful!"
+    echo "# Critical sigma:  ./$OUT -p sigma -l 0.1 -h 33"
+    echo "# Critical lambda: ./$OUT -p lambda -l 1 -h 20 -a rm"
+    echo "# =========================================="
+else
+    echo ""
+    echo "# =========================================="
+    echo "# Compilation failed!"
+    echo "# =========================================="
+    exit 1
+fi
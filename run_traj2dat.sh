@@ -0,0 +1,30 @@
+#!/bin/bash
+
+# =======================================================
+# Compilation script for the trajectory converter
+# =======================================================
+
+# Compiler settings
+GCC=gcc
+CFLAGS="-Iinclude"
+LDFLAGS="-lm"
+
+# Source files and output
+SRC="traj2dat.c src/trajectory.c"
+OUT="traj2dat"
+
+# Compile
+echo "$GCC $CFLAGS $SRC $LDFLAGS -o $OUT"
+$GCC $CFLAGS $SRC $LDFLAGS -o $OUT
+
+# Check compilation result
+if [ $? -eq 0 ]; then
+    echo ""
+    echo "# Compilation successful."
+    echo "# List frames: ./$OUT trajectory.trj"
+    echo "# Dump frame:  ./$OUT trajectory.trj 10 > frame10.dat"
+else
+    echo ""
+    echo "# Compilation error."
+    exit 1
+fi
@@ -0,0 +1,41 @@
+#!/bin/bash
+
+# =======================================================
+# Build and run the statistical equivalence harness
+# =======================================================
+#
+# Usage: ./run_validate.sh [REF] [CANDIDATE] [SEEDS] [STEPS] [BETA] [LAMBDA]
+# Exit status is 0 if the candidate kernel passes, 1 otherwise.
+
+# Kernels and run lengths
+REF=${1:-v02}           # Reference kernel
+CAND=${2:-v02}          # Candidate kernel
+SEEDS=${3:-400}         # Realizations per kernel
+STEPS=${4:-1000}        # Maximum steps per realization
+BETA=${5:-0.5}          # Recovery rate (I -> S)
+LAMBDA=${6:-1.0}        # Spatial decay of infection
+
+# Small system (compile-time parameters)
+PHI=${PHI:-0.9}
+RC=${RC:-2.5}
+N=${N:-200}
+ALPHA=${ALPHA:-1.0}
+SIGMA=${SIGMA:-0.5}
+DT=${DT:-0.01}
+
+# Compiler settings (EXTRA_CFLAGS is appended)
+GCC=gcc
+CFLAGS="-O2 -Iinclude -DPHI=${PHI} -DRC=${RC} -DN=${N} -DALPHA=${ALPHA} -DSIGMA=${SIGMA} -DDT=${DT} ${EXTRA_CFLAGS}"
+LDFLAGS="-lm -lpthread"
+
+# Source files and output
+SRC="validate.c src/system.c src/recorder.c src/offspring.c src/random.c src/instrument.c src/stats.c"
+OUT="validate"
+
+echo "$GCC $CFLAGS $SRC $LDFLAGS -o $OUT"
+$GCC $CFLAGS $SRC $LDFLAGS -o $OUT || {
+    echo "# Compilation failed!"
+    exit 2
+}
+
+./$OUT -r $REF -c $CAND -n $SEEDS -m $STEPS -b $BETA -l $LAMBDA
@@ -0,0 +1,199 @@
+#include "config.h"
+#include "random.h"
+#include "system.h"
+#include "checkpoint.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Maximum number of arrays stored in a checkpoint
+#define MAX_SECTIONS 16
+
+// One contiguous array of the system stored in the checkpoint
+typedef struct {
+    void *data;
+    size_t size;
+} section;
+
+
+// Round a file offset up to the checkpoint alignment
+static size_t alignOffset(size_t offset) {
+    return (offset + CHECKPOINT_ALIGN - 1) & ~((size_t)CHECKPOINT_ALIGN - 1);
+}
+
+
+// List the arrays stored in a checkpoint (same order for save and load)
+static int systemSections(systemSI *pS, section *s) {
+    int n = 0;
+    s[n++] = (section){pS->x,         pS->memoryX};
+    s[n++] = (section){pS->x0,        pS->memoryX};
+    s[n++] = (section){pS->index,     pS->memoryIndex};
+    s[n++] = (section){pS->state,     pS->memoryState};
+    s[n++] = (section){pS->fakeState, pS->memoryState};
+    s[n++] = (section){pS->flag,      pS->memoryFlag};
+    s[n++] = (section){pS->alpha,     N * sizeof(real)};
+    s[n++] = (section){pS->sigma,     N * sizeof(real)};
+    s[n++] = (section){pS->wheel.recoverAt, N * sizeof(long)};
+    assert(n <= MAX_SECTIONS);
+    return n;
+}
+
+
+// Total file size for a given header and list of sections
+static size_t checkpointSize(section *s, int nSections) {
+    size_t offset = alignOffset(sizeof(checkpointHeader));
+    for (int k = 0; k < nSections; k++)
+        offset = alignOffset(offset + s[k].size);
+    return offset;
+}
+
+
+// Write the whole system (and RNG state) to a file; returns 0 on success
+int saveSystem(systemSI *pS, const char *filename) {
+
+    section s[MAX_SECTIONS];
+    int nSections = systemSections(pS, s);
+
+    checkpointHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    h.version    = CHECKPOINT_VERSION;
+    h.sizeReal   = sizeof(real);
+    h.fileSize   = (long long)checkpointSize(s, nSections);
+    h.n          = N;
+    h.maxPerCell = MAX_PARTICLES_PER_CELL;
+    h.lBox       = L_BOX;
+    h.d          = pS->d;
+    h.z          = pS->z;
+    h.nCells     = pS->nCells;
+    h.idx0       = pS->idx0;
+    h.step       = pS->step;
+    h.rc         = pS->rc;
+    h.dt         = pS->dt;
+    h.cellSize   = pS->cellSize;
+    h.wheelNow   = pS->wheel.now;
+    h.wheelRate  = pS->wheel.rate;
+    h.wheelDirty = pS->wheel.dirty;
+    get_random_state(&h.rng);
+
+    // Write to a temporary file and rename, so a crash never leaves a torn checkpoint
+    size_t len = strlen(filename);
+    char *tmpName = (char *)malloc(len + 5);
+    assert(tmpName != NULL);
+    memcpy(tmpName, filename, len);
+    memcpy(tmpName + len, ".tmp", 5);
+
+    FILE *fp = fopen(tmpName, "wb");
+    if (fp == NULL) {
+        fprintf(stderr, "saveSystem: cannot open %s\n", tmpName);
+        free(tmpName);
+        return -1;
+    }
+
+    static const char zeros[CHECKPOINT_ALIGN] = {0};
+    int ok = fwrite(&h, sizeof(h), 1, fp) == 1;
+    size_t offset = sizeof(h);
+
+    for (int k = 0; k <= nSections && ok; k++) {
+        size_t pad = alignOffset(offset) - offset;
+        if (pad > 0) ok = fwrite(zeros, 1, pad, fp) == pad;
+        offset += pad;
+        if (k == nSections || !ok) break;
+        ok = fwrite(s[k].data, 1, s[k].size, fp) == s[k].size;
+        offset += s[k].size;
+    }
+
+    ok = (fclose(fp) == 0) && ok;
+    if (ok) ok = rename(tmpName, filename) == 0;
+    if (!ok) {
+        fprintf(stderr, "saveSystem: error writing %s\n", filename);
+        remove(tmpName);
+    }
+
+    free(tmpName);
+    return ok ? 0 : -1;
+}
+
+
+// Create a system from a checkpoint file and restore the RNG; NULL on error
+systemSI *loadSystem(const char *filename) {
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "loadSystem: cannot open %s\n", filename);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(checkpointHeader)) {
+        fprintf(stderr, "loadSystem: %s is not a checkpoint\n", filename);
+        close(fd);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "loadSystem: cannot map %s\n", filename);
+        return NULL;
+    }
+
+    const checkpointHeader *h = (const checkpointHeader *)map;
+    const char *error = NULL;
+
+    if (memcmp(h->magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0)
+        error = "bad magic";
+    else if (h->version != CHECKPOINT_VERSION)
+        error = "unsupported version";
+    else if (h->fileSize != (long long)st.st_size)
+        error = "truncated file";
+    else if (h->sizeReal != sizeof(real))
+        error = "precision mismatch";
+    else if (h->n != N || h->maxPerCell != MAX_PARTICLES_PER_CELL || h->lBox != L_BOX)
+        error = "compiled with different N, PHI or MAX_PARTICLES_PER_CELL";
+
+    systemSI *pS = NULL;
+    if (error == NULL) {
+        pS = makeSystem(h->rc, h->dt, 0.0, 0.0, h->d, h->z);
+        if (pS->nCells != h->nCells) {
+            error = "cell grid mismatch";
+            destroySystem(pS);
+            pS = NULL;
+        }
+    }
+
+    if (error != NULL) {
+        fprintf(stderr, "loadSystem: %s: %s\n", filename, error);
+        munmap(map, st.st_size);
+        return NULL;
+    }
+
+    // Copy arrays out of the mapping
+    section s[MAX_SECTIONS];
+    int nSections = systemSections(pS, s);
+    size_t offset = alignOffset(sizeof(checkpointHeader));
+    for (int k = 0; k < nSections; k++) {
+        memcpy(s[k].data, (const char *)map + offset, s[k].size);
+        offset = alignOffset(offset + s[k].size);
+    }
+
+    pS->idx0 = h->idx0;
+    pS->step = h->step;
+    pS->cellSize = h->cellSize;
+    pS->wheel.now = h->wheelNow;
+    pS->wheel.rate = h->wheelRate;
+    pS->wheel.dirty = h->wheelDirty;
+    set_random_state(&h->rng);
+
+    munmap(map, st.st_size);
+
+    // Rebuild derived structures (particles were saved grouped by class)
+    getNeighborList(pS);
+    getCellIndex(pS);
+    groupMobilityClasses(pS);
+    relinkRecoveries(pS);
+
+    return pS;
+}
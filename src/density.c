@@ -0,0 +1,370 @@
+#include <unistd.h>
+#include "config.h"
+#include "system.h"
+#include "density.h"
+
+
+// Continue a field file written for the same system and grid: drop a
+// partial frame and the frames from the current step on (written after the
+// last checkpoint); 0 if the file is ready for appending
+static int resumeDensityFile(densityField *f, const char *filename, systemSI *pS) {
+    densityHeader h;
+    FILE *fp = openDensityFile(filename, &h);
+    if (fp == NULL) return -1;
+    fclose(fp);
+    if (h.n != N || h.m != f->m || h.lBox != L_BOX) {
+        fprintf(stderr, "makeDensityField: %s: not a field file of this system and grid\n", filename);
+        return -1;
+    }
+
+    f->fp = fopen(filename, "r+b");
+    if (f->fp == NULL) {
+        fprintf(stderr, "makeDensityField: cannot open %s\n", filename);
+        return -1;
+    }
+
+    // Frames have a fixed size and are written in step order
+    long frameSize = (long)sizeof(densityFrame) + 2L * f->m * f->m * sizeof(unsigned short);
+    fseek(f->fp, 0, SEEK_END);
+    long nFrames = (ftell(f->fp) - (long)sizeof(h)) / frameSize;
+    long kept = 0;
+    densityFrame frame;
+    while (kept < nFrames) {
+        fseek(f->fp, sizeof(h) + kept * frameSize, SEEK_SET);
+        if (fread(&frame, sizeof(frame), 1, f->fp) != 1 || frame.step >= pS->step) break;
+        kept++;
+    }
+
+    long end = sizeof(h) + kept * frameSize;
+    if (ftruncate(fileno(f->fp), end) != 0) {
+        perror("makeDensityField: ftruncate");
+        return -1;
+    }
+    fseek(f->fp, end, SEEK_SET);
+    return 0;
+}
+
+
+densityField *makeDensityField(systemSI *pS, int m, const char *filename, int append) {
+    // Radix-2 transform
+    assert(m >= 2 && (m & (m - 1)) == 0);
+
+    densityField *f = (densityField *)calloc(1, sizeof(densityField));
+    assert(f != NULL);
+
+    f->m = m;
+    f->nBins = m / 2;
+    f->rho        = (double *)malloc(m * m * sizeof(double));
+    f->rhoI       = (double *)malloc(m * m * sizeof(double));
+    f->re         = (double *)malloc(m * m * sizeof(double));
+    f->im         = (double *)malloc(m * m * sizeof(double));
+    f->cosTable   = (double *)malloc((m / 2) * sizeof(double));
+    f->sinTable   = (double *)malloc((m / 2) * sizeof(double));
+    f->bitReverse = (int *)malloc(m * sizeof(int));
+    f->window     = (double *)malloc(m * sizeof(double));
+    f->sk         = (double *)calloc(f->nBins, sizeof(double));
+    f->skI        = (double *)calloc(f->nBins, sizeof(double));
+    f->modes      = (long long *)calloc(f->nBins, sizeof(long long));
+    f->q          = (unsigned short *)malloc(m * m * sizeof(unsigned short));
+    assert(f->rho != NULL && f->rhoI != NULL && f->re != NULL && f->im != NULL &&
+           f->cosTable != NULL && f->sinTable != NULL && f->bitReverse != NULL &&
+           f->window != NULL && f->sk != NULL && f->skI != NULL && f->modes != NULL && f->q != NULL);
+
+    for (int k = 0; k < m / 2; k++) {
+        f->cosTable[k] = cos(2.0 * M_PI * k / m);
+        f->sinTable[k] = sin(2.0 * M_PI * k / m);
+    }
+
+    int bits = 0;
+    while ((1 << bits) < m) bits++;
+    for (int i = 0; i < m; i++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++)
+            if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+        f->bitReverse[i] = r;
+    }
+
+    // CIC window summed over aliases, per axis
+    for (int k = 0; k < m; k++) {
+        double s = sin(M_PI * k / m);
+        f->window[k] = 1.0 - 2.0 / 3.0 * s * s;
+    }
+
+    // Modes per shell (shell b holds |n| in [b + 0.5, b + 1.5))
+    for (int ky = 0; ky < m; ky++) {
+        for (int kx = 0; kx < m; kx++) {
+            int nx = (kx <= m / 2) ? kx : kx - m;
+            int ny = (ky <= m / 2) ? ky : ky - m;
+            int b = (int)(sqrt((double)(nx * nx + ny * ny)) + 0.5) - 1;
+            if (b >= 0 && b < f->nBins) f->modes[b]++;
+        }
+    }
+
+    if (filename != NULL && append && access(filename, F_OK) == 0) {
+        if (resumeDensityFile(f, filename, pS) != 0) {
+            destroyDensityField(f);
+            return NULL;
+        }
+    } else if (filename != NULL) {
+        f->fp = fopen(filename, "wb");
+        if (f->fp == NULL) {
+            fprintf(stderr, "makeDensityField: cannot open %s\n", filename);
+            destroyDensityField(f);
+            return NULL;
+        }
+        densityHeader h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, DENSITY_MAGIC, sizeof(DENSITY_MAGIC));
+        h.version = DENSITY_VERSION;
+        h.n = N;
+        h.m = m;
+        h.lBox = L_BOX;
+        h.dt = pS->dt;
+        fwrite(&h, sizeof(h), 1, f->fp);
+    }
+
+    return f;
+}
+
+
+void destroyDensityField(densityField *f) {
+    if (f == NULL) return;
+
+    if (f->fp != NULL) fclose(f->fp);
+    free(f->rho);
+    free(f->rhoI);
+    free(f->re);
+    free(f->im);
+    free(f->cosTable);
+    free(f->sinTable);
+    free(f->bitReverse);
+    free(f->window);
+    free(f->sk);
+    free(f->skI);
+    free(f->modes);
+    free(f->q);
+    free(f);
+}
+
+
+// Cloud-in-cell counts: each particle is shared by the four cells whose
+// centers surround it, with bilinear weights (periodic)
+void depositDensity(densityField *f, systemSI *pS) {
+    int m = f->m;
+    int d = pS->d;
+    double invH = m / (double)L_BOX;
+
+    memset(f->rho, 0, m * m * sizeof(double));
+    memset(f->rhoI, 0, m * m * sizeof(double));
+    f->nInfected = 0;
+
+    for (int idx = 0; idx < N; idx++) {
+        double gx = pS->x[d * idx + 0] * invH - 0.5;
+        double gy = pS->x[d * idx + 1] * invH - 0.5;
+        int ix = (int)floor(gx);
+        int iy = (int)floor(gy);
+        double fx = gx - ix, fy = gy - iy;
+
+        int ix0 = (ix % m + m) % m, ix1 = (ix0 + 1) % m;
+        int iy0 = (iy % m + m) % m, iy1 = (iy0 + 1) % m;
+
+        double w00 = (1.0 - fx) * (1.0 - fy), w10 = fx * (1.0 - fy);
+        double w01 = (1.0 - fx) * fy,         w11 = fx * fy;
+
+        f->rho[iy0 * m + ix0] += w00;
+        f->rho[iy0 * m + ix1] += w10;
+        f->rho[iy1 * m + ix0] += w01;
+        f->rho[iy1 * m + ix1] += w11;
+
+        if (pS->state[idx] == 0) {
+            f->nInfected++;
+            f->rhoI[iy0 * m + ix0] += w00;
+            f->rhoI[iy0 * m + ix1] += w10;
+            f->rhoI[iy1 * m + ix0] += w01;
+            f->rhoI[iy1 * m + ix1] += w11;
+        }
+    }
+}
+
+
+// Iterative radix-2 transform of m points spaced by stride
+static void fft1d(densityField *f, double *re, double *im, int stride) {
+    int m = f->m;
+
+    for (int i = 0; i < m; i++) {
+        int j = f->bitReverse[i];
+        if (j > i) {
+            double t = re[i * stride]; re[i * stride] = re[j * stride]; re[j * stride] = t;
+            t = im[i * stride]; im[i * stride] = im[j * stride]; im[j * stride] = t;
+        }
+    }
+
+    for (int len = 2; len <= m; len <<= 1) {
+        int half = len / 2;
+        int step = m / len;
+        for (int start = 0; start < m; start += len) {
+            for (int k = 0; k < half; k++) {
+                double wr = f->cosTable[k * step];
+                double wi = -f->sinTable[k * step];
+                int a = (start + k) * stride;
+                int b = (start + k + half) * stride;
+                double tr = re[b] * wr - im[b] * wi;
+                double ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
+
+
+// Rows, then columns
+void fft2d(densityField *f, double *re, double *im) {
+    int m = f->m;
+    for (int row = 0; row < m; row++) fft1d(f, re + row * m, im + row * m, 1);
+    for (int col = 0; col < m; col++) fft1d(f, re + col, im + col, m);
+}
+
+
+// Both fields in one transform: Z = FFT(rho + i rhoI) gives
+// FFT(rho) = (Z(k) + Z*(-k)) / 2 and FFT(rhoI) = (Z(k) - Z*(-k)) / 2i
+void structureFactor(densityField *f) {
+    int m = f->m;
+    double *re = f->re, *im = f->im;
+
+    memcpy(re, f->rho, m * m * sizeof(double));
+    memcpy(im, f->rhoI, m * m * sizeof(double));
+    fft2d(f, re, im);
+
+    memset(f->sk, 0, f->nBins * sizeof(double));
+    memset(f->skI, 0, f->nBins * sizeof(double));
+
+    for (int ky = 0; ky < m; ky++) {
+        int ny = (ky <= m / 2) ? ky : ky - m;
+        int kyMinus = (m - ky) % m;
+
+        for (int kx = 0; kx < m; kx++) {
+            int nx = (kx <= m / 2) ? kx : kx - m;
+            int b = (int)(sqrt((double)(nx * nx + ny * ny)) + 0.5) - 1;
+            if (b < 0 || b >= f->nBins) continue;
+
+            int k = ky * m + kx;
+            int kMinus = kyMinus * m + (m - kx) % m;
+            double zr = re[k], zi = im[k];
+            double wr = re[kMinus], wi = im[kMinus];
+
+            double all = 0.25 * ((zr + wr) * (zr + wr) + (zi - wi) * (zi - wi));
+            double inf = 0.25 * ((zi + wi) * (zi + wi) + (zr - wr) * (zr - wr));
+            double window = f->window[kx] * f->window[ky];
+
+            f->sk[b] += all / window;
+            f->skI[b] += inf / window;
+        }
+    }
+
+    for (int b = 0; b < f->nBins; b++) {
+        f->sk[b] /= (double)f->modes[b] * N;
+        f->skI[b] = (f->nInfected > 0) ? f->skI[b] / ((double)f->modes[b] * f->nInfected) : 0.0;
+    }
+}
+
+
+// One field of a frame, 16 bits per cell
+static void writeField(densityField *f, const double *field, double scale) {
+    int mm = f->m * f->m;
+    for (int i = 0; i < mm; i++)
+        f->q[i] = (scale > 0.0) ? (unsigned short)(field[i] / scale + 0.5) : 0;
+    fwrite(f->q, sizeof(unsigned short), mm, f->fp);
+}
+
+
+static double fieldScale(const double *field, int mm) {
+    double max = 0.0;
+    for (int i = 0; i < mm; i++)
+        if (field[i] > max) max = field[i];
+    return max / 65535.0;
+}
+
+
+void measureDensity(densityField *f, systemSI *pS) {
+    depositDensity(f, pS);
+    structureFactor(f);
+
+    if (f->fp != NULL) {
+        int mm = f->m * f->m;
+        densityFrame frame;
+        memset(&frame, 0, sizeof(frame));
+        frame.step = pS->step;
+        frame.nInfected = f->nInfected;
+        frame.scale[0] = fieldScale(f->rho, mm);
+        frame.scale[1] = fieldScale(f->rhoI, mm);
+        fwrite(&frame, sizeof(frame), 1, f->fp);
+        writeField(f, f->rho, frame.scale[0]);
+        writeField(f, f->rhoI, frame.scale[1]);
+    }
+}
+
+
+void printDensityHeader(densityField *f, FILE *fp) {
+    fprintf(fp, "#@ sk:  step time S(k) of all particles at the wavenumbers of #@k\n");
+    fprintf(fp, "#@ ski: step time infected S(k) of infected particles\n");
+    fprintf(fp, "#@k");
+    for (int b = 0; b < f->nBins; b++)
+        fprintf(fp, "\t%.4f", 2.0 * M_PI * (b + 1) / L_BOX);
+    fprintf(fp, "\n");
+}
+
+
+// Structure factors of the last measureDensity call
+void printStructureFactor(densityField *f, systemSI *pS, FILE *fp) {
+    double time = pS->step * pS->dt;
+
+    fprintf(fp, "#@sk\t%ld\t%.4f", pS->step, time);
+    for (int b = 0; b < f->nBins; b++)
+        fprintf(fp, "\t%.4f", f->sk[b]);
+    fprintf(fp, "\n");
+
+    fprintf(fp, "#@ski\t%ld\t%.4f\t%d", pS->step, time, f->nInfected);
+    for (int b = 0; b < f->nBins; b++)
+        fprintf(fp, "\t%.4f", f->skI[b]);
+    fprintf(fp, "\n");
+}
+
+
+// Open a field file for reading and check its header
+FILE *openDensityFile(const char *filename, densityHeader *h) {
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "openDensityFile: cannot open %s\n", filename);
+        return NULL;
+    }
+    if (fread(h, sizeof(*h), 1, fp) != 1 || memcmp(h->magic, DENSITY_MAGIC, sizeof(DENSITY_MAGIC)) != 0 ||
+        h->version != DENSITY_VERSION || h->m < 1) {
+        fprintf(stderr, "openDensityFile: %s: not a density file\n", filename);
+        fclose(fp);
+        return NULL;
+    }
+    return fp;
+}
+
+
+// Read the next frame (fields of m * m cells); returns 0 at the end of the file
+int readDensityFrame(FILE *fp, const densityHeader *h, densityFrame *frame, float *all, float *infected) {
+    int mm = h->m * h->m;
+    if (fread(frame, sizeof(*frame), 1, fp) != 1) return 0;
+
+    unsigned short *q = (unsigned short *)malloc(mm * sizeof(unsigned short));
+    assert(q != NULL);
+
+    int ok = 1;
+    float *fields[2] = {all, infected};
+    for (int k = 0; k < 2 && ok; k++) {
+        if (fread(q, sizeof(unsigned short), mm, fp) != (size_t)mm) ok = 0;
+        else for (int i = 0; i < mm; i++) fields[k][i] = (float)(q[i] * frame->scale[k]);
+    }
+
+    free(q);
+    return ok;
+}
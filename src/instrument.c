@@ -0,0 +1,76 @@
+#include "config.h"
+#include "system.h"
+#include "instrument.h"
+
+#ifdef INSTRUMENT
+
+instrumentCounters instr;
+
+static const char *phaseName[N_PHASES] = {"iteration", "getCellIndex", "propagation"};
+
+
+// Monotonic time in nanoseconds
+double instrumentNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+// Add the current occupancy of every cell to the histogram
+void instrumentOccupancy(systemSI *pS) {
+    int nCells = pS->nCells;
+    for (int cellIdx = 0; cellIdx < nCells * nCells; cellIdx++) {
+        int k = pS->cellList[cellIdx].nParticles;
+        instr.occupancy[k]++;
+        if (k > instr.maxOccupancy) instr.maxOccupancy = k;
+    }
+    instr.cellSamples += nCells * nCells;
+}
+
+
+// A cell is about to receive more than MAX_PARTICLES_PER_CELL particles
+void instrumentOverflow(int cellIdx, int count) {
+    fprintf(stderr, "# INSTRUMENT: cell %d overflow (%d particles, MAX_PARTICLES_PER_CELL=%d)\n",
+            cellIdx, count + 1, MAX_PARTICLES_PER_CELL);
+    instrumentReport(stderr);
+    abort();
+}
+
+
+// Print a summary of all counters as '#' comment lines
+void instrumentReport(FILE *fp) {
+    long long steps = instr.steps > 0 ? instr.steps : 1;
+    double total = 0.0;
+    for (int p = 0; p < N_PHASES; p++) total += instr.phaseNs[p];
+
+    fprintf(fp, "# ===== Instrumentation (%lld steps) =====\n", instr.steps);
+    fprintf(fp, "# Phase\t\tcalls\ttime[s]\tns/particle/call\tshare\n");
+    for (int p = 0; p < N_PHASES; p++) {
+        long long calls = instr.phaseCalls[p] > 0 ? instr.phaseCalls[p] : 1;
+        fprintf(fp, "# %-12s\t%lld\t%.4f\t%.3f\t\t%.1f%%\n", phaseName[p], instr.phaseCalls[p],
+                instr.phaseNs[p] * 1e-9, instr.phaseNs[p] / ((double)calls * N),
+                total > 0.0 ? 100.0 * instr.phaseNs[p] / total : 0.0);
+    }
+
+    fprintf(fp, "# Pair candidates: %lld (%.1f/step), within rc: %lld (%.1f%%)\n",
+            instr.pairCandidates, (double)instr.pairCandidates / steps, instr.pairsInRange,
+            instr.pairCandidates > 0 ? 100.0 * instr.pairsInRange / instr.pairCandidates : 0.0);
+    fprintf(fp, "# RNG draws: %lld (%.1f/step)\n", instr.rngDraws, (double)instr.rngDraws / steps);
+
+    fprintf(fp, "# Cell occupancy: max %d of MAX_PARTICLES_PER_CELL=%d\n",
+            instr.maxOccupancy, MAX_PARTICLES_PER_CELL);
+    if (instr.cellSamples > 0) {
+        fprintf(fp, "# Occupancy\tfraction\n");
+        for (int k = 0; k <= instr.maxOccupancy; k++)
+            fprintf(fp, "# %d\t\t%.6f\n", k, (double)instr.occupancy[k] / instr.cellSamples);
+    }
+}
+
+
+// Zero all counters
+void instrumentReset(void) {
+    memset(&instr, 0, sizeof(instr));
+}
+
+#endif // INSTRUMENT
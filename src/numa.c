@@ -0,0 +1,245 @@
+#define _GNU_SOURCE
+#include <sched.h>
+#include <dirent.h>
+#include <unistd.h>
+#include "config.h"
+#include "system.h"
+#include "numa.h"
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#define NUMA_SYSFS      "/sys/devices/system/node"
+#define NUMA_MF_MOVE    (1 << 1)   // MPOL_MF_MOVE: move pages owned by this process
+#define NUMA_PAGE_BATCH 1024       // Pages per move_pages call
+
+
+// Mark the CPUs of a sysfs list ("0-3,8,10-11") as belonging to node
+static void parseCpuList(const char *list, int node, int *nodeOfCpu, int nCpus) {
+    const char *p = list;
+    while (*p != '\0' && *p != '\n') {
+        char *end;
+        long lo = strtol(p, &end, 10);
+        if (end == p) break;
+        long hi = lo;
+        if (*end == '-') {
+            p = end + 1;
+            hi = strtol(p, &end, 10);
+        }
+        for (long c = lo; c <= hi; c++)
+            if (c >= 0 && c < nCpus) nodeOfCpu[c] = node;
+        p = (*end == ',') ? end + 1 : end;
+    }
+}
+
+
+static int compareInt(const void *a, const void *b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+
+numaTopology *numaDetect(void) {
+    numaTopology *t = (numaTopology *)calloc(1, sizeof(numaTopology));
+    assert(t != NULL);
+
+    t->nCpus = (int)sysconf(_SC_NPROCESSORS_CONF);
+    if (t->nCpus < 1) t->nCpus = 1;
+    t->nodeOfCpu = (int *)malloc(t->nCpus * sizeof(int));
+    assert(t->nodeOfCpu != NULL);
+
+    // Node numbers from the nodeK entries (they need not be contiguous)
+    int capacity = 8;
+    t->nodeId = (int *)malloc(capacity * sizeof(int));
+    assert(t->nodeId != NULL);
+
+    DIR *dir = opendir(NUMA_SYSFS);
+    if (dir != NULL) {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            int id;
+            char tail;
+            if (sscanf(entry->d_name, "node%d%c", &id, &tail) != 1) continue;
+            if (t->nNodes == capacity) {
+                capacity *= 2;
+                t->nodeId = (int *)realloc(t->nodeId, capacity * sizeof(int));
+                assert(t->nodeId != NULL);
+            }
+            t->nodeId[t->nNodes++] = id;
+        }
+        closedir(dir);
+    }
+    qsort(t->nodeId, t->nNodes, sizeof(int), compareInt);
+
+    for (int c = 0; c < t->nCpus; c++) t->nodeOfCpu[c] = -1;
+    for (int n = 0; n < t->nNodes; n++) {
+        char path[256], list[4096];
+        snprintf(path, sizeof(path), NUMA_SYSFS "/node%d/cpulist", t->nodeId[n]);
+        FILE *fp = fopen(path, "r");
+        if (fp == NULL) continue;
+        if (fgets(list, sizeof(list), fp) != NULL) parseCpuList(list, n, t->nodeOfCpu, t->nCpus);
+        fclose(fp);
+    }
+
+    // One node holding every CPU
+    t->fromSysfs = (t->nNodes > 0);
+    if (!t->fromSysfs) {
+        t->nNodes = 1;
+        t->nodeId[0] = 0;
+        for (int c = 0; c < t->nCpus; c++) t->nodeOfCpu[c] = 0;
+    }
+
+    return t;
+}
+
+
+void numaFree(numaTopology *t) {
+    if (t == NULL) return;
+
+    free(t->nodeOfCpu);
+    free(t->nodeId);
+    free(t);
+}
+
+
+// Index of a sysfs node number (-1 if unknown)
+static int nodeIndex(const numaTopology *t, int id) {
+    for (int n = 0; n < t->nNodes; n++)
+        if (t->nodeId[n] == id) return n;
+    return -1;
+}
+
+
+int numaPinNode(const numaTopology *t, int node) {
+    int n = nodeIndex(t, node);
+    if (n < 0) {
+        fprintf(stderr, "numaPinNode: no node %d (nodes:", node);
+        for (int k = 0; k < t->nNodes; k++) fprintf(stderr, " %d", t->nodeId[k]);
+        fprintf(stderr, ")\n");
+        return -1;
+    }
+
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    int count = 0;
+    for (int c = 0; c < t->nCpus && c < CPU_SETSIZE; c++) {
+        if (t->nodeOfCpu[c] == n) {
+            CPU_SET(c, &set);
+            count++;
+        }
+    }
+    if (count == 0) {
+        fprintf(stderr, "numaPinNode: node %d has no CPUs\n", node);
+        return -1;
+    }
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        perror("numaPinNode: sched_setaffinity");
+        return -1;
+    }
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+
+// move_pages on a batch of pages: query (nodes == NULL) or move
+static long movePages(unsigned long count, void **pages, const int *nodes, int *status) {
+#if defined(__linux__) && defined(SYS_move_pages)
+    return syscall(SYS_move_pages, 0, count, pages, nodes, status, nodes != NULL ? NUMA_MF_MOVE : 0);
+#else
+    (void)count; (void)pages; (void)nodes; (void)status;
+    return -1;
+#endif
+}
+
+
+int numaNodeOfAddress(const numaTopology *t, const void *address) {
+    long pageSize = sysconf(_SC_PAGESIZE);
+    void *page = (void *)((unsigned long)address & ~(unsigned long)(pageSize - 1));
+    int status = -1;
+
+    if (movePages(1, &page, NULL, &status) != 0 || status < 0 || nodeIndex(t, status) < 0) return -1;
+    return status;
+}
+
+
+long numaMovePages(const numaTopology *t, void *address, size_t size, int node) {
+    if (nodeIndex(t, node) < 0) return -1;
+
+    long pageSize = sysconf(_SC_PAGESIZE);
+    unsigned long first = (unsigned long)address & ~(unsigned long)(pageSize - 1);
+    unsigned long last = ((unsigned long)address + size + pageSize - 1) & ~(unsigned long)(pageSize - 1);
+    long nPages = (long)((last - first) / pageSize);
+
+    void *pages[NUMA_PAGE_BATCH];
+    int nodes[NUMA_PAGE_BATCH], status[NUMA_PAGE_BATCH];
+    long failed = 0;
+
+    for (long p = 0; p < nPages; p += NUMA_PAGE_BATCH) {
+        int count = (nPages - p < NUMA_PAGE_BATCH) ? (int)(nPages - p) : NUMA_PAGE_BATCH;
+        for (int k = 0; k < count; k++) {
+            pages[k] = (void *)(first + (unsigned long)(p + k) * pageSize);
+            nodes[k] = node;
+        }
+        if (movePages(count, pages, nodes, status) < 0) return -1;
+        for (int k = 0; k < count; k++)
+            if (status[k] != node) failed++;
+    }
+    return failed;
+}
+
+
+void numaReport(const numaTopology *t, systemSI *pS, FILE *fp) {
+    fprintf(fp, "# NUMA: %d node%s (%s):", t->nNodes, t->nNodes > 1 ? "s" : "",
+            t->fromSysfs ? "sysfs" : "no topology, one node assumed");
+    for (int n = 0; n < t->nNodes; n++) {
+        int count = 0;
+        for (int c = 0; c < t->nCpus; c++) count += (t->nodeOfCpu[c] == n);
+        fprintf(fp, " node%d %d cpus%s", t->nodeId[n], count, n < t->nNodes - 1 ? "," : "\n");
+    }
+
+#ifdef __linux__
+    int cpu = sched_getcpu();
+    int allowed = 0;
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) allowed = CPU_COUNT(&set);
+    if (cpu >= 0 && cpu < t->nCpus && t->nodeOfCpu[cpu] >= 0)
+        fprintf(fp, "# NUMA: running on cpu %d (node%d), %d cpus allowed\n",
+                cpu, t->nodeId[t->nodeOfCpu[cpu]], allowed);
+#endif
+
+    if (pS == NULL) return;
+
+    // Pages of the arena per node
+    long pageSize = sysconf(_SC_PAGESIZE);
+    unsigned long first = (unsigned long)pS->arena & ~(unsigned long)(pageSize - 1);
+    long nPages = (long)(((unsigned long)pS->arena + pS->memoryArena - first + pageSize - 1) / pageSize);
+    long *perNode = (long *)calloc(t->nNodes + 1, sizeof(long));   // Last entry: unknown
+    assert(perNode != NULL);
+
+    void *pages[NUMA_PAGE_BATCH];
+    int status[NUMA_PAGE_BATCH];
+    for (long p = 0; p < nPages; p += NUMA_PAGE_BATCH) {
+        int count = (nPages - p < NUMA_PAGE_BATCH) ? (int)(nPages - p) : NUMA_PAGE_BATCH;
+        for (int k = 0; k < count; k++)
+            pages[k] = (void *)(first + (unsigned long)(p + k) * pageSize);
+        if (movePages(count, pages, NULL, status) != 0) {
+            perNode[t->nNodes] += count;
+            continue;
+        }
+        for (int k = 0; k < count; k++) {
+            int n = (status[k] >= 0) ? nodeIndex(t, status[k]) : -1;
+            perNode[(n >= 0) ? n : t->nNodes]++;
+        }
+    }
+
+    fprintf(fp, "# NUMA: arena %.1f MB in %ld pages:", pS->memoryArena / 1048576.0, nPages);
+    for (int n = 0; n < t->nNodes; n++)
+        fprintf(fp, " node%d %.0f%%", t->nodeId[n], 100.0 * perNode[n] / nPages);
+    if (perNode[t->nNodes] > 0) fprintf(fp, " unknown %.0f%%", 100.0 * perNode[t->nNodes] / nPages);
+    fprintf(fp, "\n");
+
+    free(perNode);
+}
@@ -0,0 +1,168 @@
+#include "config.h"
+#include "system.h"
+#include "observables.h"
+
+
+// Cell holding a particle (as in getCellIndex)
+static int cellOf(systemSI *pS, int idx) {
+    int nCells = pS->nCells;
+    int ix = ((int)(pS->x[pS->d * idx + 0] / pS->cellSize)) % nCells;
+    int iy = ((int)(pS->x[pS->d * idx + 1] / pS->cellSize)) % nCells;
+    if (ix < 0) ix += nCells;
+    if (iy < 0) iy += nCells;
+    return iy * nCells + ix;
+}
+
+
+observables *makeObservables(systemSI *pS, double rMax, int nBins) {
+    observables *obs = (observables *)calloc(1, sizeof(observables));
+    assert(obs != NULL);
+
+    // Beyond L_BOX / 2 a pair could be counted through two images
+    if (rMax > 0.5 * L_BOX) rMax = 0.5 * L_BOX;
+    obs->rMax = rMax;
+    obs->nBins = nBins;
+    obs->binWidth = rMax / nBins;
+
+    obs->nOffsets = cellStencil(pS->cellSize, rMax, NULL);
+    obs->offsets   = (int *)malloc(2 * obs->nOffsets * sizeof(int));
+    obs->pairs     = (long long *)calloc(nBins, sizeof(long long));
+    obs->g         = (double *)calloc(nBins, sizeof(double));
+    obs->sizeCount = (int *)calloc(N + 1, sizeof(int));
+    assert(obs->offsets != NULL && obs->pairs != NULL && obs->g != NULL &&
+           obs->sizeCount != NULL);
+    cellStencil(pS->cellSize, rMax, obs->offsets);
+
+    return obs;
+}
+
+
+void destroyObservables(observables *obs) {
+    if (obs == NULL) return;
+
+    free(obs->offsets);
+    free(obs->pairs);
+    free(obs->g);
+    free(obs->sizeCount);
+    free(obs);
+}
+
+
+// Mean over particles of |x - x0|^2 (minimum image)
+double meanSquaredDisplacement(systemSI *pS) {
+    int d = pS->d;
+    double sum = 0.0;
+
+    for (int idx = 0; idx < N; idx++) {
+        for (int mu = 0; mu < d; mu++) {
+            double dx = minImage(pS->x[d * idx + mu], pS->x0[d * idx + mu]);
+            sum += dx * dx;
+        }
+    }
+    return sum / N;
+}
+
+
+// Histogram of infected-infected distances below rMax over the cells within
+// rMax of each infected particle. Every cell image is visited once, so with
+// rMax <= L_BOX / 2 each ordered pair is counted once.
+void infectedPairCorrelation(observables *obs, systemSI *pS) {
+    int *state = pS->state;
+    real *x = pS->x;
+    int d = pS->d;
+    int nCells = pS->nCells;
+    double rMax2 = obs->rMax * obs->rMax;
+    int nInfected = 0;
+
+    memset(obs->pairs, 0, obs->nBins * sizeof(long long));
+
+    for (int idx = 0; idx < N; idx++) {
+        if (state[idx] != 0) continue;
+        nInfected++;
+
+        int cellIdx = cellOf(pS, idx);
+        int i = cellIdx % nCells;
+        int j = cellIdx / nCells;
+        real xi = x[d * idx + 0];
+        real yi = x[d * idx + 1];
+
+        for (int n = 0; n < obs->nOffsets; n++) {
+            int si = i + obs->offsets[2 * n + 0];
+            int sj = j + obs->offsets[2 * n + 1];
+            int ni = (si % nCells + nCells) % nCells;
+            int nj = (sj % nCells + nCells) % nCells;
+            cell *c = &pS->cellList[ni + nj * nCells];
+
+            // Image of the wrapped cell next to this one
+            real sx = ((si - ni) / nCells) * (real)L_BOX - xi;
+            real sy = ((sj - nj) / nCells) * (real)L_BOX - yi;
+
+            for (int p = 0; p < c->nParticles; p++) {
+                int jdx = c->particleIndex[p];
+                if (jdx == idx || state[jdx] != 0) continue;
+
+                real dx = x[d * jdx + 0] + sx;
+                real dy = x[d * jdx + 1] + sy;
+                double r2 = dx * dx + dy * dy;
+                if (r2 < rMax2) {
+                    int b = (int)(sqrt(r2) / obs->binWidth);
+                    if (b < obs->nBins) obs->pairs[b]++;
+                }
+            }
+        }
+    }
+
+    // Ordered pairs expected in each shell for uniform positions
+    double area = (double)L_BOX * L_BOX;
+    for (int b = 0; b < obs->nBins; b++) {
+        double r0 = b * obs->binWidth, r1 = r0 + obs->binWidth;
+        double expected = (double)nInfected * (nInfected - 1) * M_PI * (r1 * r1 - r0 * r0) / area;
+        obs->g[b] = (expected > 0.0) ? obs->pairs[b] / expected : 0.0;
+    }
+    obs->nInfected = nInfected;
+}
+
+
+// Clusters of infected particles (labels left in pS->cluster)
+void infectedClusters(observables *obs, systemSI *pS) {
+    obs->nClusters = labelClusters(pS, obs->sizeCount, &obs->largest);
+}
+
+
+// Refresh the cell lists (positions may have moved since the last
+// propagation) and compute all observables
+void measureObservables(observables *obs, systemSI *pS) {
+    getCellIndex(pS);
+    obs->msd = meanSquaredDisplacement(pS);
+    infectedPairCorrelation(obs, pS);
+    infectedClusters(obs, pS);
+}
+
+
+void printObservablesHeader(observables *obs, FILE *fp) {
+    fprintf(fp, "#@ msd: step time <|x - x0|^2>\n");
+    fprintf(fp, "#@ gr:  step time infected g(r) at the bin centers of #@r\n");
+    fprintf(fp, "#@ cl:  step time clusters largest size:count...\n");
+    fprintf(fp, "#@r");
+    for (int b = 0; b < obs->nBins; b++)
+        fprintf(fp, "\t%.4f", (b + 0.5) * obs->binWidth);
+    fprintf(fp, "\n");
+}
+
+
+// Observables of the last measureObservables call
+void printObservables(observables *obs, systemSI *pS, FILE *fp) {
+    double time = pS->step * pS->dt;
+
+    fprintf(fp, "#@msd\t%ld\t%.4f\t%.6g\n", pS->step, time, obs->msd);
+
+    fprintf(fp, "#@gr\t%ld\t%.4f\t%d", pS->step, time, obs->nInfected);
+    for (int b = 0; b < obs->nBins; b++)
+        fprintf(fp, "\t%.4f", obs->g[b]);
+    fprintf(fp, "\n");
+
+    fprintf(fp, "#@cl\t%ld\t%.4f\t%d\t%d", pS->step, time, obs->nClusters, obs->largest);
+    for (int s = 1; s <= obs->largest; s++)
+        if (obs->sizeCount[s] > 0) fprintf(fp, "\t%d:%d", s, obs->sizeCount[s]);
+    fprintf(fp, "\n");
+}
@@ -0,0 +1,112 @@
+#include "config.h"
+#include "system.h"
+#include "offspring.h"
+
+
+// Allocate a tracker for nGenerations and attach it to the system
+offspringTracker *makeOffspringTracker(systemSI *pS, int nGenerations) {
+    offspringTracker *t = (offspringTracker *)calloc(1, sizeof(offspringTracker));
+    assert(t != NULL);
+
+    t->nGenerations = nGenerations;
+    t->generation = (int *)malloc(N * sizeof(int));
+    t->offspring  = (int *)calloc(N, sizeof(int));
+    t->samples    = (long long *)calloc(nGenerations, sizeof(long long));
+    t->sum        = (double *)calloc(nGenerations, sizeof(double));
+    t->sumSq      = (double *)calloc(nGenerations, sizeof(double));
+    t->histogram  = (long long *)calloc(nGenerations * OFFSPRING_MAX, sizeof(long long));
+    assert(t->generation != NULL && t->offspring != NULL && t->samples != NULL &&
+           t->sum != NULL && t->sumSq != NULL && t->histogram != NULL);
+
+    for (int i = 0; i < N; i++) t->generation[i] = -1;
+
+    pS->offspring = t;
+    return t;
+}
+
+
+void destroyOffspringTracker(offspringTracker *t, systemSI *pS) {
+    if (t == NULL) return;
+
+    if (pS != NULL && pS->offspring == t) pS->offspring = NULL;
+    free(t->generation);
+    free(t->offspring);
+    free(t->samples);
+    free(t->sum);
+    free(t->sumSq);
+    free(t->histogram);
+    free(t);
+}
+
+
+// Start a realization: currently infected particles open generation 0
+// (periods left open by the previous realization are discarded)
+void startOffspring(offspringTracker *t, systemSI *pS) {
+    for (int i = 0; i < N; i++) {
+        t->generation[i] = (pS->state[i] == 0) ? 0 : -1;
+        t->offspring[i] = 0;
+    }
+}
+
+
+// Close the open period of a particle and add its sample
+void offspringRecovery(offspringTracker *t, int idx) {
+    int g = t->generation[idx];
+    if (g < 0) return;
+
+    if (g < t->nGenerations) {
+        int k = t->offspring[idx];
+        t->samples[g]++;
+        t->sum[g] += k;
+        t->sumSq[g] += (double)k * k;
+        t->histogram[g * OFFSPRING_MAX + (k < OFFSPRING_MAX ? k : OFFSPRING_MAX - 1)]++;
+    }
+
+    t->generation[idx] = -1;
+    t->offspring[idx] = 0;
+}
+
+
+// Count an infection for the infector and open the infectee's period one
+// generation later (infector < 0: unknown, the infectee is not followed)
+void offspringInfection(offspringTracker *t, int infectee, int infector) {
+    // Recovered and reinfected within one step (versions 3 and 4)
+    if (t->generation[infectee] >= 0) offspringRecovery(t, infectee);
+
+    if (infector < 0 || t->generation[infector] < 0) return;
+
+    t->offspring[infector]++;
+    t->generation[infectee] = t->generation[infector] + 1;
+}
+
+
+// Per generation: samples, mean, variance and dispersion k (negative binomial)
+void printOffspringStats(offspringTracker *t, FILE *fp) {
+    fprintf(fp, "# Gen\tSamples\tR\tVar\tk\n");
+    for (int g = 0; g < t->nGenerations; g++) {
+        long long n = t->samples[g];
+        if (n == 0) continue;
+
+        double mean = t->sum[g] / n;
+        double var = (n > 1) ? (t->sumSq[g] - n * mean * mean) / (n - 1) : 0.0;
+
+        // Moment estimate of the negative binomial k (inf: not overdispersed)
+        double k = (var > mean) ? mean * mean / (var - mean) : INFINITY;
+        fprintf(fp, "%d\t%lld\t%.6f\t%.6f\t%.4f\n", g, n, mean, var, k);
+    }
+}
+
+
+// Fraction of completed periods of each generation with k offspring
+void printOffspringDistribution(offspringTracker *t, FILE *fp) {
+    fprintf(fp, "# Gen\tOffspring\tFraction\n");
+    for (int g = 0; g < t->nGenerations; g++) {
+        long long n = t->samples[g];
+        if (n == 0) continue;
+
+        int last = OFFSPRING_MAX - 1;
+        while (last > 0 && t->histogram[g * OFFSPRING_MAX + last] == 0) last--;
+        for (int k = 0; k <= last; k++)
+            fprintf(fp, "%d\t%d\t%.6f\n", g, k, (double)t->histogram[g * OFFSPRING_MAX + k] / n);
+    }
+}
@@ -0,0 +1,192 @@
+// =======================================================
+//   Generic propagation kernel (included by system.c)
+// =======================================================
+//
+// No include guard: system.c includes this file once per kernel, after
+// defining the policies below. Policies are compile-time constants, so each
+// instance keeps only its own path (no policy tests in its loops).
+//
+//   KERNEL_NAME        function to define: int KERNEL_NAME(systemSI *, double beta, double lambda)
+//   KERNEL_RULE        RULE_SPONTANEOUS  S -> I with probability beta dt, no contacts
+//                      RULE_COUNT        1 - exp(-beta n dt), n infected neighbors within rc
+//                      RULE_DISTANCE     1 - prod_j (1 - exp(-lambda r_j) dt) over infected neighbors
+//   KERNEL_SEARCH      SEARCH_NONE       no neighbor search
+//                      SEARCH_ALL        every susceptible searches its neighbor cells
+//                      SEARCH_IDX0       only susceptibles near idx0 (infected by idx0 alone,
+//                                        one draw per pair; RULE_DISTANCE only)
+//   KERNEL_RECOVERY    recovery rate expression (beta, or lambda in the rate models)
+//   KERNEL_TRACK_FLAG  1: set flag[i] on infection (ever infected)
+//   KERNEL_COUNT       COUNT_NONE (returns 0), COUNT_INFECTED, COUNT_EVER (flags set)
+//
+// Kernels with RULE_DISTANCE record events and count offspring; the others
+// do not.
+
+int KERNEL_NAME(systemSI *pS, double beta, double lambda) {
+    memcpy(pS->fakeState, pS->state, pS->memoryState);
+
+    int *state     = pS->state;
+    int *fakeState = pS->fakeState;
+    int *flag      = pS->flag;
+    double dt = pS->dt;
+    real rc = pS->rc;
+    int d = pS->d;
+    int z = pS->z;
+    real *x = pS->x;
+    int nCells = pS->nCells;
+
+    // Draws kept to attribute infections (searches over all particles)
+    double *draws = (KERNEL_RULE == RULE_DISTANCE && KERNEL_SEARCH == SEARCH_ALL &&
+                     (pS->rec != NULL || pS->offspring != NULL)) ? pS->noInfection : NULL;
+
+    // Update cell lists
+    if (KERNEL_SEARCH != SEARCH_NONE) getCellIndex(pS);
+
+    INSTR_BEGIN(PHASE_PROPAGATION);
+
+    // Infected -> Susceptible (scheduled recovery)
+    popRecoveries(pS, KERNEL_RECOVERY);
+
+    if (KERNEL_SEARCH == SEARCH_IDX0) {
+        int idx0 = pS->idx0;
+
+        // Find idx0's cell
+        real x0 = x[d * idx0 + 0];
+        real y0 = x[d * idx0 + 1];
+        int ix0 = ((int)(x0 / pS->cellSize)) % nCells;
+        int iy0 = ((int)(y0 / pS->cellSize)) % nCells;
+        if (ix0 < 0) ix0 += nCells;
+        if (iy0 < 0) iy0 += nCells;
+        int cellIdx0 = iy0 * nCells + ix0;
+
+        // Search only in neighbor cells of idx0, if it is infected
+        if (state[idx0] == 0) {
+            for (int n = 0; n < z; n++) {
+                int neighborCellIdx = pS->neighborCell[z * cellIdx0 + n];
+                real sx = pS->neighborShift[2 * (z * cellIdx0 + n) + 0] - x0;
+                real sy = pS->neighborShift[2 * (z * cellIdx0 + n) + 1] - y0;
+
+                for (int p = 0; p < pS->cellList[neighborCellIdx].nParticles; p++) {
+                    int idx = pS->cellList[neighborCellIdx].particleIndex[p];
+
+                    INSTR_ADD(pairCandidates, 1);
+                    if (idx == idx0) continue;              // Skip idx0 itself
+                    if (fakeState[idx] != 1) continue;      // Only susceptibles (recovered now included)
+
+                    // Distance to the image next to idx0
+                    real dx = x[d * idx + 0] + sx;
+                    real dy = x[d * idx + 1] + sy;
+                    real dist = REAL_SQRT(dx*dx + dy*dy);
+
+                    if (dist < rc) {
+                        INSTR_ADD(pairsInRange, 1);
+
+                        // P(infection) = exp(-lambda*r) * dt
+                        double infection_prob = REAL_EXP(-(real)lambda * dist) * dt;
+                        double r_random = uniform_pos();
+
+                        if (r_random < infection_prob) {
+                            if (pS->rec != NULL)
+                                recordEvent(pS->rec, pS->step, EVENT_INFECTION, pS->index[idx], pS->index[idx0], (float)dist);
+                            if (pS->offspring != NULL)
+                                offspringInfection(pS->offspring, idx, idx0);
+                            fakeState[idx] = 0;
+                            if (KERNEL_TRACK_FLAG) flag[idx] = 1;
+                            scheduleRecovery(pS, idx);
+                        }
+                    }
+                }
+            }
+        }
+    } else {
+        for (int idx = 0; idx < N; idx++) {
+            if (state[idx] == 0) continue;
+
+            double r_random = uniform_pos();
+            if (draws != NULL) draws[idx] = r_random;
+
+            // P(infection) of this susceptible
+            double infection_prob;
+
+            if (KERNEL_SEARCH == SEARCH_NONE) {
+                infection_prob = beta * dt;
+            } else {
+                int num_infected_neighbors = 0;
+                double prob_no_infection = 1.0;
+
+                real xi = x[d * idx + 0];
+                real yi = x[d * idx + 1];
+
+                // Find particle's cell
+                int ix = ((int)(xi / pS->cellSize)) % nCells;
+                int iy = ((int)(yi / pS->cellSize)) % nCells;
+                if (ix < 0) ix += nCells;
+                if (iy < 0) iy += nCells;
+                int cellIdx = iy * nCells + ix;
+
+                // Search for infected neighbors
+                for (int n = 0; n < z; n++) {
+                    int neighborCellIdx = pS->neighborCell[z * cellIdx + n];
+                    real sx = pS->neighborShift[2 * (z * cellIdx + n) + 0] - xi;
+                    real sy = pS->neighborShift[2 * (z * cellIdx + n) + 1] - yi;
+
+                    for (int p = 0; p < pS->cellList[neighborCellIdx].nParticles; p++) {
+                        int jdx = pS->cellList[neighborCellIdx].particleIndex[p];
+
+                        INSTR_ADD(pairCandidates, 1);
+                        if (jdx == idx) continue;
+                        if (state[jdx] != 0) continue; // Only infected
+
+                        real dx = x[d * jdx + 0] + sx;
+                        real dy = x[d * jdx + 1] + sy;
+
+                        if (KERNEL_RULE == RULE_COUNT) {
+                            if (dx*dx + dy*dy < rc*rc) {
+                                INSTR_ADD(pairsInRange, 1);
+                                num_infected_neighbors++;
+                            }
+                        } else {
+                            real dist = REAL_SQRT(dx*dx + dy*dy);
+                            if (dist < rc) {
+                                INSTR_ADD(pairsInRange, 1);
+
+                                // P(this neighbor does NOT infect me) = 1 - exp(-lambda*r) * dt
+                                prob_no_infection *= 1.0 - REAL_EXP(-(real)lambda * dist) * dt;
+                            }
+                        }
+                    }
+                }
+
+                if (KERNEL_RULE == RULE_COUNT)
+                    infection_prob = 1.0 - exp(-beta * num_infected_neighbors * dt);
+                else
+                    infection_prob = 1.0 - prob_no_infection;
+            }
+
+            if (r_random < infection_prob) {
+                fakeState[idx] = 0;
+                if (KERNEL_TRACK_FLAG) flag[idx] = 1;
+                scheduleRecovery(pS, idx);
+            }
+        }
+    }
+
+    if (draws != NULL) attributeInfections(pS, lambda, draws);
+    if (KERNEL_RULE == RULE_DISTANCE) closeRecoveries(pS);
+    memcpy(state, fakeState, pS->memoryState);
+
+    int count = 0;
+    if (KERNEL_COUNT == COUNT_INFECTED)
+        for (int idx = 0; idx < N; idx++) count += (state[idx] == 0);
+    else if (KERNEL_COUNT == COUNT_EVER)
+        for (int idx = 0; idx < N; idx++) count += (flag[idx] == 1);
+
+    INSTR_END(PHASE_PROPAGATION);
+    return count;
+}
+
+#undef KERNEL_NAME
+#undef KERNEL_RULE
+#undef KERNEL_SEARCH
+#undef KERNEL_RECOVERY
+#undef KERNEL_TRACK_FLAG
+#undef KERNEL_COUNT
@@ -1,7 +1,14 @@
 #include "random.h"
+#include "instrument.h"
 
+// Generator state (xorshift64*), kept in one place so it can be saved/restored
+static unsigned long long rngS = 0;
 static int seeded = 0;
 
+// Box-Muller spare value, part of the generator state
+static int haveSpare = 0;
+static double spare;
+
 // =======================================================
 //   Initialization
 // =======================================================
@@ -10,7 +17,31 @@ static int seeded = 0;
 void seed_random(unsigned int seed) {
     if (seed == 0)
         seed = (unsigned int)time(NULL);
-    srand(seed);
+
+    // Spread the seed over 64 bits with one splitmix64 round (state must be non-zero)
+    unsigned long long z = (unsigned long long)seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z = z ^ (z >> 31);
+    rngS = (z != 0) ? z : 0x9E3779B97F4A7C15ULL;
+
+    haveSpare = 0;
+    seeded = 1;
+}
+
+// Copy the full generator state (including the Gaussian spare) into *st
+void get_random_state(rngState *st) {
+    if (!seeded) seed_random(0);
+    st->s = rngS;
+    st->haveSpare = haveSpare;
+    st->spare = spare;
+}
+
+// Restore a generator state previously obtained with get_random_state
+void set_random_state(const rngState *st) {
+    rngS = st->s;
+    haveSpare = st->haveSpare;
+    spare = st->spare;
     seeded = 1;
 }
 
@@ -21,7 +52,13 @@ void seed_random(unsigned int seed) {
 // Return uniform random number in [0,1)
 double uniform_pos(void) {
     if (!seeded) seed_random(0);
-    return rand() / (RAND_MAX + 1.0);
+    INSTR_ADD(rngDraws, 1);
+
+    // xorshift64* step, top 53 bits mapped to [0,1)
+    rngS ^= rngS >> 12;
+    rngS ^= rngS << 25;
+    rngS ^= rngS >> 27;
+    return (double)((rngS * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
 }
 
 // Return uniform random number in [a,b)
@@ -35,9 +72,6 @@ double uniform_range(double a, double b) {
 
 // Return Gaussian random number with mean=0 and std=1
 double gasdev(void) {
-    static int haveSpare = 0;
-    static double spare;
-    
     // Use spare value from previous call if available
     if (haveSpare) {
         haveSpare = 0;
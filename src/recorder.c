@@ -0,0 +1,184 @@
+#include <unistd.h>
+#include "config.h"
+#include "system.h"
+#include "recorder.h"
+
+
+// Writer thread: write each handed-off buffer, exit when stopped and idle
+static void *writerLoop(void *arg) {
+    recorder *rec = (recorder *)arg;
+
+    pthread_mutex_lock(&rec->lock);
+    for (;;) {
+        while (rec->pending < 0 && !rec->stop)
+            pthread_cond_wait(&rec->cond, &rec->lock);
+        if (rec->pending < 0) break;
+
+        eventRecord *buffer = rec->buffer[rec->pending];
+        int count = rec->pendingCount;
+        pthread_mutex_unlock(&rec->lock);
+
+        if (fwrite(buffer, sizeof(eventRecord), count, rec->fp) != (size_t)count)
+            fprintf(stderr, "recorder: write failed, %d events lost\n", count);
+
+        pthread_mutex_lock(&rec->lock);
+        rec->pending = -1;
+        pthread_cond_broadcast(&rec->cond);
+    }
+    pthread_mutex_unlock(&rec->lock);
+    return NULL;
+}
+
+
+// Hand the active buffer to the writer (waits if it is still busy)
+static void handOff(recorder *rec) {
+    pthread_mutex_lock(&rec->lock);
+    while (rec->pending >= 0)
+        pthread_cond_wait(&rec->cond, &rec->lock);
+    rec->pending = rec->active;
+    rec->pendingCount = rec->count;
+    pthread_cond_broadcast(&rec->cond);
+    pthread_mutex_unlock(&rec->lock);
+
+    rec->active ^= 1;
+    rec->count = 0;
+}
+
+
+// Open (or append to) an event file and attach the recorder to the system
+recorder *openRecorder(const char *filename, systemSI *pS, int append) {
+    recorderHeader h;
+    FILE *fp = NULL;
+
+    // Append only to a file written for the same system
+    if (append) {
+        fp = fopen(filename, "r+b");
+        if (fp != NULL) {
+            if (fread(&h, sizeof(h), 1, fp) != 1 || memcmp(h.magic, RECORDER_MAGIC, sizeof(RECORDER_MAGIC)) != 0 ||
+                h.version != RECORDER_VERSION || h.n != N) {
+                fprintf(stderr, "openRecorder: %s: not an event file of this system\n", filename);
+                fclose(fp);
+                return NULL;
+            }
+
+            // Drop a partial record and the events after the restored step
+            // (written after the last checkpoint); steps never decrease
+            fseek(fp, 0, SEEK_END);
+            long lo = 0, hi = (ftell(fp) - (long)sizeof(h)) / (long)sizeof(eventRecord);
+            while (lo < hi) {
+                long mid = (lo + hi) / 2;
+                eventRecord e;
+                fseek(fp, sizeof(h) + mid * sizeof(eventRecord), SEEK_SET);
+                if (fread(&e, sizeof(e), 1, fp) != 1 || e.step > pS->step) hi = mid;
+                else lo = mid + 1;
+            }
+            long end = sizeof(h) + lo * sizeof(eventRecord);
+            if (ftruncate(fileno(fp), end) != 0) perror("openRecorder: ftruncate");
+            fseek(fp, end, SEEK_SET);
+        }
+    }
+
+    int fresh = (fp == NULL);
+    if (fresh) {
+        fp = fopen(filename, "wb");
+        if (fp == NULL) {
+            fprintf(stderr, "openRecorder: cannot open %s\n", filename);
+            return NULL;
+        }
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, RECORDER_MAGIC, sizeof(RECORDER_MAGIC));
+        h.version = RECORDER_VERSION;
+        h.n = N;
+        h.dt = pS->dt;
+        h.lBox = L_BOX;
+        fwrite(&h, sizeof(h), 1, fp);
+    }
+
+    recorder *rec = (recorder *)calloc(1, sizeof(recorder));
+    assert(rec != NULL);
+    rec->fp = fp;
+    rec->pending = -1;
+    for (int b = 0; b < 2; b++) {
+        rec->buffer[b] = (eventRecord *)malloc(RECORDER_BUFFER * sizeof(eventRecord));
+        assert(rec->buffer[b] != NULL);
+    }
+    pthread_mutex_init(&rec->lock, NULL);
+    pthread_cond_init(&rec->cond, NULL);
+    int status = pthread_create(&rec->thread, NULL, writerLoop, rec);
+    assert(status == 0);
+
+    // Infected particles at the start of a new file are the seeds
+    if (fresh)
+        for (int i = 0; i < N; i++)
+            if (pS->state[i] == 0) recordEvent(rec, pS->step, EVENT_SEED, pS->index[i], -1, 0.0f);
+
+    pS->rec = rec;
+    return rec;
+}
+
+
+// Append one event (called from the propagation kernels)
+void recordEvent(recorder *rec, long long step, int type, int infectee, int infector, float distance) {
+    rec->buffer[rec->active][rec->count++] = (eventRecord){step, type, infectee, infector, distance};
+    rec->nEvents++;
+    if (rec->count == RECORDER_BUFFER) handOff(rec);
+}
+
+
+// Write out all events recorded so far (before a checkpoint)
+void flushRecorder(recorder *rec) {
+    if (rec == NULL) return;
+
+    if (rec->count > 0) handOff(rec);
+
+    pthread_mutex_lock(&rec->lock);
+    while (rec->pending >= 0)
+        pthread_cond_wait(&rec->cond, &rec->lock);
+    fflush(rec->fp);
+    pthread_mutex_unlock(&rec->lock);
+}
+
+
+// Flush the remaining events, stop the writer and detach from the system
+void closeRecorder(recorder *rec, systemSI *pS) {
+    if (rec == NULL) return;
+
+    if (rec->count > 0) handOff(rec);
+
+    pthread_mutex_lock(&rec->lock);
+    rec->stop = 1;
+    pthread_cond_broadcast(&rec->cond);
+    pthread_mutex_unlock(&rec->lock);
+    pthread_join(rec->thread, NULL);
+
+    fclose(rec->fp);
+    pthread_mutex_destroy(&rec->lock);
+    pthread_cond_destroy(&rec->cond);
+    free(rec->buffer[0]);
+    free(rec->buffer[1]);
+    if (pS != NULL && pS->rec == rec) pS->rec = NULL;
+    free(rec);
+}
+
+
+// Open an event file for reading and check its header
+FILE *openEventFile(const char *filename, recorderHeader *h) {
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "openEventFile: cannot open %s\n", filename);
+        return NULL;
+    }
+    if (fread(h, sizeof(*h), 1, fp) != 1 || memcmp(h->magic, RECORDER_MAGIC, sizeof(RECORDER_MAGIC)) != 0 ||
+        h->version != RECORDER_VERSION) {
+        fprintf(stderr, "openEventFile: %s: not an event file\n", filename);
+        fclose(fp);
+        return NULL;
+    }
+    return fp;
+}
+
+
+// Read up to n events; a trailing partial record is ignored
+int readEvents(FILE *fp, eventRecord *events, int n) {
+    return (int)fread(events, sizeof(eventRecord), n, fp);
+}
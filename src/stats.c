@@ -0,0 +1,147 @@
+#include "config.h"
+#include "stats.h"
+
+#define ITMAX 200
+#define EPS   3.0e-12
+#define FPMIN 1.0e-300
+
+// Minimum combined count of a bin in the chi-square test
+#define MIN_BIN_COUNT 5.0
+
+
+// =======================================================
+//   Special functions (Numerical Recipes)
+// =======================================================
+
+// Series representation of the incomplete gamma function P(a, x)
+static double gser(double a, double x) {
+    double ap = a;
+    double sum = 1.0 / a;
+    double del = sum;
+    for (int n = 0; n < ITMAX; n++) {
+        ap += 1.0;
+        del *= x / ap;
+        sum += del;
+        if (fabs(del) < fabs(sum) * EPS) break;
+    }
+    return sum * exp(-x + a * log(x) - lgamma(a));
+}
+
+
+// Continued fraction representation of Q(a, x)
+static double gcf(double a, double x) {
+    double b = x + 1.0 - a;
+    double c = 1.0 / FPMIN;
+    double d = 1.0 / b;
+    double h = d;
+    for (int i = 1; i <= ITMAX; i++) {
+        double an = -i * (i - a);
+        b += 2.0;
+        d = an * d + b;
+        if (fabs(d) < FPMIN) d = FPMIN;
+        c = b + an / c;
+        if (fabs(c) < FPMIN) c = FPMIN;
+        d = 1.0 / d;
+        double del = d * c;
+        h *= del;
+        if (fabs(del - 1.0) < EPS) break;
+    }
+    return exp(-x + a * log(x) - lgamma(a)) * h;
+}
+
+
+// Complementary incomplete gamma function Q(a, x)
+double gammq(double a, double x) {
+    assert(a > 0.0 && x >= 0.0);
+    if (x == 0.0) return 1.0;
+    return (x < a + 1.0) ? 1.0 - gser(a, x) : gcf(a, x);
+}
+
+
+// Kolmogorov distribution tail Q_KS(lambda)
+double probks(double alam) {
+    double a2 = -2.0 * alam * alam;
+    double fac = 2.0;
+    double sum = 0.0;
+    double termbf = 0.0;
+    for (int j = 1; j <= 100; j++) {
+        double term = fac * exp(a2 * j * j);
+        sum += term;
+        if (fabs(term) <= 0.001 * termbf || fabs(term) <= 1.0e-8 * sum) return sum;
+        fac = -fac;
+        termbf = fabs(term);
+    }
+    return 1.0;  // Failed to converge: lambda ~ 0
+}
+
+
+// =======================================================
+//   Two-sample tests
+// =======================================================
+
+static int compareDouble(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+
+// Kolmogorov-Smirnov test of two samples (arrays are sorted in place)
+double ksTwoSample(double *data1, int n1, double *data2, int n2, double *d) {
+    qsort(data1, n1, sizeof(double), compareDouble);
+    qsort(data2, n2, sizeof(double), compareDouble);
+
+    int j1 = 0, j2 = 0;
+    double fn1 = 0.0, fn2 = 0.0;
+    *d = 0.0;
+
+    // Walk both empirical CDFs, stepping over ties in both samples at once
+    while (j1 < n1 && j2 < n2) {
+        double v = (data1[j1] <= data2[j2]) ? data1[j1] : data2[j2];
+        while (j1 < n1 && data1[j1] == v) j1++;
+        while (j2 < n2 && data2[j2] == v) j2++;
+        fn1 = (double)j1 / n1;
+        fn2 = (double)j2 / n2;
+        double dt = fabs(fn2 - fn1);
+        if (dt > *d) *d = dt;
+    }
+
+    double en = sqrt((double)n1 * n2 / (n1 + n2));
+    return probks((en + 0.12 + 0.11 / en) * (*d));
+}
+
+
+// Chi-square test of two binned distributions with different totals
+double chiSquareTwoSample(const double *bins1, const double *bins2, int nBins, double *chsq, int *df) {
+    double total1 = 0.0, total2 = 0.0;
+    for (int j = 0; j < nBins; j++) {
+        total1 += bins1[j];
+        total2 += bins2[j];
+    }
+
+    double k1 = sqrt(total2 / total1);
+    double k2 = sqrt(total1 / total2);
+
+    *chsq = 0.0;
+    *df = -1;
+    double acc1 = 0.0, acc2 = 0.0;
+    for (int j = 0; j < nBins; j++) {
+        acc1 += bins1[j];
+        acc2 += bins2[j];
+
+        // Close the merged bin once it is populated enough (or at the end)
+        if (acc1 + acc2 < MIN_BIN_COUNT && j < nBins - 1) continue;
+        if (acc1 + acc2 > 0.0) {
+            double temp = k1 * acc1 - k2 * acc2;
+            *chsq += temp * temp / (acc1 + acc2);
+            (*df)++;
+        }
+        acc1 = acc2 = 0.0;
+    }
+
+    if (*df < 1) {
+        *df = 0;
+        return 1.0;   // A single bin: the distributions cannot be told apart
+    }
+    return gammq(0.5 * (*df), 0.5 * (*chsq));
+}
@@ -1,76 +1,147 @@
 #include "config.h"
 #include "random.h"
 #include "system.h"
+#include "instrument.h"
+#include "recorder.h"
+#include "offspring.h"
+
+// Choose the number of cells per cutoff radius (1-3) minimizing the expected
+// cost per particle: stencil cells visited plus candidate pairs checked
+static int chooseCellDivisions(double rc) {
+    if (CELL_DIVISIONS > 0)
+        return CELL_DIVISIONS;
+
+    int best = 1;
+    double bestCost = 0.0;
+    for (int k = 1; k <= 3; k++) {
+        int nCells = (int)(L_BOX / (rc / k));
+        if (nCells < 1) break;
+        double cellSize = L_BOX / nCells;
+        int reach = (int)ceil(rc / cellSize);
+
+        // Stencil must not wrap onto itself (k = 1 is always allowed)
+        if (k > 1 && nCells < 2 * reach + 1) break;
+
+        int z = cellStencil(cellSize, rc, NULL);
+        double cost = z * (CELL_VISIT_COST + PHI * cellSize * cellSize);
+        if (k == 1 || cost < bestCost) {
+            best = k;
+            bestCost = cost;
+        }
+    }
+    return best;
+}
+
+
+// Round an arena offset up to the arena alignment
+static size_t alignArena(size_t offset) {
+    return (offset + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1);
+}
+
 
 // Create and initialize the system with given parameters
 systemSI *makeSystem(double rc, double dt, double alpha, double sigma, int d, int z) {
 
     // Allocate memory for system structure
-    systemSI *pS = (systemSI *)malloc(sizeof(systemSI));
+    systemSI *pS = (systemSI *)calloc(1, sizeof(systemSI));
     assert(pS != NULL);
 
     // Set system parameters
     pS->rc = rc;
     pS->dt = dt;
-    pS->nCells = N_BOX;
-    pS->cellSize = L_BOX / N_BOX;
+    pS->cellDivisions = chooseCellDivisions(rc);
+    pS->nCells = (int)(L_BOX / (rc / pS->cellDivisions));
+    if (pS->nCells < 1) pS->nCells = 1;
+    pS->cellSize = L_BOX / pS->nCells;
     pS->d = d;
-    pS->z = z;
+    pS->z = z = cellStencil(pS->cellSize, rc, NULL);
+    pS->step = 0;
+
+    int nCells = pS->nCells;
 
     // Calculate memory sizes for arrays
-    pS->memoryX = d * N * sizeof(double);
+    pS->memoryX = d * N * sizeof(real);
     pS->memoryIndex = N * sizeof(int);
     pS->memoryState = N * sizeof(int);
     pS->memoryFlag = N * sizeof(int);
-    pS->memoryNeighborCell = z * N_BOX * N_BOX * sizeof(int);
-    pS->memoryCellList = N_BOX * N_BOX * sizeof(cell);
+    pS->memoryNeighborCell = z * nCells * nCells * sizeof(int);
+    pS->memoryNeighborShift = d * z * nCells * nCells * sizeof(real);
+    pS->memoryCellList = nCells * nCells * sizeof(cell);
+
+    pS->memoryCellStorage = nCells * nCells * MAX_PARTICLES_PER_CELL * sizeof(int);
+    pS->memoryClasses = MOBILITY_CLASSES * MOBILITY_CLASSES * sizeof(mobilityClass);
+    pS->memoryWheel = RECOVERY_WHEEL * sizeof(int);
+
+    // Carve every array from one aligned arena
+    size_t offset = 0;
+    size_t offX           = offset; offset = alignArena(offset + pS->memoryX);
+    size_t offX0          = offset; offset = alignArena(offset + pS->memoryX);
+    size_t offAlpha       = offset; offset = alignArena(offset + N * sizeof(real));
+    size_t offSigma       = offset; offset = alignArena(offset + N * sizeof(real));
+    size_t offNoInfection = offset; offset = alignArena(offset + N * sizeof(double));
+    size_t offIndex       = offset; offset = alignArena(offset + pS->memoryIndex);
+    size_t offState       = offset; offset = alignArena(offset + pS->memoryState);
+    size_t offFakeState   = offset; offset = alignArena(offset + pS->memoryState);
+    size_t offFlag        = offset; offset = alignArena(offset + pS->memoryFlag);
+    size_t offNeighbor    = offset; offset = alignArena(offset + pS->memoryNeighborCell);
+    size_t offShift       = offset; offset = alignArena(offset + pS->memoryNeighborShift);
+    size_t offCellList    = offset; offset = alignArena(offset + pS->memoryCellList);
+    size_t offCellStorage = offset; offset = alignArena(offset + pS->memoryCellStorage);
+    size_t offClasses     = offset; offset = alignArena(offset + pS->memoryClasses);
+    size_t offRecoverAt   = offset; offset = alignArena(offset + N * sizeof(long));
+    size_t offNext        = offset; offset = alignArena(offset + N * sizeof(int));
+    size_t offPrev        = offset; offset = alignArena(offset + N * sizeof(int));
+    size_t offDue         = offset; offset = alignArena(offset + N * sizeof(int));
+    size_t offHead        = offset; offset = alignArena(offset + pS->memoryWheel);
+    size_t offCluster     = offset; offset = alignArena(offset + N * sizeof(int));
+    pS->memoryArena = offset;
+
+    void *arena = NULL;
+    int status = posix_memalign(&arena, ARENA_ALIGN, pS->memoryArena);
+    assert(status == 0 && arena != NULL);
+    memset(arena, 0, pS->memoryArena);
+    pS->arena = arena;
+
+    char *base = (char *)arena;
+    pS->x            = (real *)(base + offX);
+    pS->x0           = (real *)(base + offX0);
+    pS->alpha        = (real *)(base + offAlpha);
+    pS->sigma        = (real *)(base + offSigma);
+    pS->noInfection  = (double *)(base + offNoInfection);  // Scratch buffer of the pair kernels
+    pS->index        = (int *)(base + offIndex);
+    pS->state        = (int *)(base + offState);
+    pS->fakeState    = (int *)(base + offFakeState);
+    pS->flag         = (int *)(base + offFlag);
+    pS->neighborCell = (int *)(base + offNeighbor);
+    pS->neighborShift = (real *)(base + offShift);
+    pS->cellList     = (cell *)(base + offCellList);
+    pS->classes      = (mobilityClass *)(base + offClasses);
+    pS->wheel.recoverAt = (long *)(base + offRecoverAt);
+    pS->wheel.next      = (int *)(base + offNext);
+    pS->wheel.prev      = (int *)(base + offPrev);
+    pS->wheel.due       = (int *)(base + offDue);
+    pS->wheel.head      = (int *)(base + offHead);
+    pS->cluster         = (int *)(base + offCluster);
+    for (int i = 0; i < N; i++) pS->wheel.recoverAt[i] = -1;
+    for (int b = 0; b < RECOVERY_WHEEL; b++) pS->wheel.head[b] = -1;
+
+    // Each cell owns a fixed slice of the particle storage
+    int *cellStorage = (int *)(base + offCellStorage);
+    for (int cellIdx = 0; cellIdx < nCells * nCells; cellIdx++) {
+        pS->cellList[cellIdx].nParticles = 0;
+        pS->cellList[cellIdx].particleIndex = cellStorage + cellIdx * MAX_PARTICLES_PER_CELL;
+    }
 
-    pS -> sigma = (double *)malloc(N * sizeof(double));
-    pS -> alpha = (double *)malloc(N * sizeof(double));
-    assert(pS -> sigma != NULL && pS -> alpha != NULL);
+    for (int i = 0; i < N; i++) pS->index[i] = i;
 
     uniformSigma(pS, sigma);
     uniformAlpha(pS, alpha);
 
-    // Allocate position arrays
-    pS->x  = (double *)malloc(pS->memoryX);
-    pS->x0 = (double *)malloc(pS->memoryX);
-    assert(pS->x != NULL && pS->x0 != NULL);
-
-    // Initialize particle positions randomly
-    putParticles(pS);
-    memcpy(pS->x0, pS->x, pS->memoryX);  // Copy to equilibrium positions
-
-    // Allocate index array
-    pS->index = (int *)malloc(pS->memoryIndex);
-    assert(pS->index != NULL);
-
-    // Allocate state arrays
-    pS->state     = (int *)malloc(pS->memoryState);
-    pS->fakeState = (int *)malloc(pS->memoryState);
-    pS->flag      = (int *)malloc(pS->memoryFlag);
-    assert(pS->state != NULL && pS->fakeState != NULL && pS->flag != NULL);
-
-    // Set initial epidemic states
-    initialState(pS);
-
-    // Allocate and build neighbor cell list
-    pS->neighborCell = (int *)malloc(pS->memoryNeighborCell);
-    assert(pS->neighborCell != NULL);
+    // Build neighbor cell list
     getNeighborList(pS);
 
-    // Allocate cell list structure
-    pS->cellList = (cell *)malloc(pS->memoryCellList);
-    assert(pS->cellList != NULL);
-
-    // Initialize each cell
-    for (int cellIdx = 0; cellIdx < N_BOX * N_BOX; cellIdx++) {
-        pS->cellList[cellIdx].nParticles = 0;
-        pS->cellList[cellIdx].particleIndex = (int *)calloc(MAX_PARTICLES_PER_CELL, sizeof(int));
-    }
-    
-    // Assign particles to cells
-    getCellIndex(pS);
+    // Random positions and initial epidemic states
+    resetSystem(pS);
 
     return pS;
 }
@@ -81,38 +152,64 @@ void destroySystem(systemSI *pS) {
     if (pS == NULL)
         return;
 
-    // Free main arrays
-    free(pS->x);
-    free(pS->x0);
-    free(pS->index);
-    free(pS->state);
-    free(pS -> sigma);
-    free(pS -> alpha);
-    free(pS -> flag);
-    free(pS -> fakeState);
-    free(pS -> neighborCell);
-
-    // Free cell list arrays
-    if (pS->cellList != NULL) {
-        for (int i = 0; i < pS->nCells * pS->nCells; i++) {
-            free(pS->cellList[i].particleIndex);
-            pS->cellList[i].particleIndex = NULL;
-        }
-        free(pS->cellList);
-        pS->cellList = NULL;
-    }
-
-    // Free system structure
+    free(pS->arena);
     free(pS);
 }
 
 
+// Start a new realization in place: new equilibrium and stationary
+// positions, one random infected particle and step counter at zero
+// (mobility parameters are kept)
+void resetSystem(systemSI *pS) {
+
+    // Random equilibrium positions, particles drawn around them
+    putParticles(pS);
+
+    // Set initial epidemic states
+    initialState(pS);
+
+    // Assign particles to cells
+    getCellIndex(pS);
+
+    pS->step = 0;
+}
+
+
 // Initialize particle positions randomly in the box
 void putParticles(systemSI *pS) {
     int d = pS->d;
     for (int i = 0; i < N; i++) {
-        pS->x[d * i + 0] = ((double)rand() / (double)RAND_MAX) * L_BOX;
-        pS->x[d * i + 1] = ((double)rand() / (double)RAND_MAX) * L_BOX;
+        pS->x0[d * i + 0] = uniform_range(0.0, L_BOX);
+        pS->x0[d * i + 1] = uniform_range(0.0, L_BOX);
+    }
+
+    // Displacements from the stationary distribution (no burn-in needed)
+    relaxParticles(pS);
+}
+
+
+// Draw every displacement x - x0 from the stationary OU distribution
+// N(0, sigma^2/(2 alpha)) per coordinate; particles without restoring
+// force (alpha <= 0) are left at their equilibrium positions
+void relaxParticles(systemSI *pS) {
+    int d = pS->d;
+    real L = L_BOX;
+
+    for (int idx = 0; idx < N; idx++) {
+        double alpha = pS->alpha[idx];
+        double std = (alpha > 0.0) ? pS->sigma[idx] / sqrt(2.0 * alpha) : 0.0;
+
+        for (int mu = 0; mu < d; mu++) {
+            int pos = d * idx + mu;
+            real newx = pS->x0[pos];
+            if (std > 0.0) newx += std * gasdev();
+
+            // Apply periodic boundary conditions (wrap around)
+            newx = REAL_FMOD(newx, L);
+            if (newx < 0) newx += L;
+
+            pS->x[pos] = newx;
+        }
     }
 }
 
@@ -126,19 +223,22 @@ void initialState(systemSI *pS) {
     }
 
     // Choose one random particle to be infected (state=0)
-    int j = (int)(((double)rand() / (double)RAND_MAX) * N);
+    int j = (int)(uniform_pos() * N);
     if (j < 0) j = 0;
     if (j >= N) j = N-1;
     pS -> state[j] = 0;
     pS->flag[j]=1;
     pS-> idx0 = j;
+    pS->wheel.dirty = 1;
 }
 
 
 // Assign particles to spatial cells based on their positions
 void getCellIndex(systemSI *pS) {
 
-    double *x = pS->x;
+    INSTR_BEGIN(PHASE_CELLS);
+
+    real *x = pS->x;
     double cellSize = pS->cellSize;
     int nCells = pS->nCells;
     int d = pS->d;
@@ -162,436 +262,601 @@ void getCellIndex(systemSI *pS) {
 
         // Add particle to cell
         int current_count = pS->cellList[cellIdx].nParticles;
+        INSTR_CHECK_CELL(cellIdx, current_count);
         pS->cellList[cellIdx].particleIndex[current_count] = idx;
 
         // Increment particle count
         pS->cellList[cellIdx].nParticles++;
     }
+
+    INSTR_END(PHASE_CELLS);
+    INSTR_OCCUPANCY(pS);
+}
+
+
+// Cell offsets (di, dj) whose cells can hold a particle within rc of a
+// particle in the central cell, in lexicographic (dj, di) order, so the
+// central cell sits in the middle of the list. Returns the number of cells.
+int cellStencil(double cellSize, double rc, int *offsets) {
+    int reach = (int)ceil(rc / cellSize);
+    int n = 0;
+
+    for (int dj = -reach; dj <= reach; dj++) {
+        for (int di = -reach; di <= reach; di++) {
+
+            // Smallest distance between points of the two cells
+            double gx = (abs(di) > 0) ? (abs(di) - 1) * cellSize : 0.0;
+            double gy = (abs(dj) > 0) ? (abs(dj) - 1) * cellSize : 0.0;
+
+            if (gx * gx + gy * gy < rc * rc) {
+                if (offsets != NULL) {
+                    offsets[2 * n + 0] = di;
+                    offsets[2 * n + 1] = dj;
+                }
+                n++;
+            }
+        }
+    }
+    return n;
 }
 
 
 // Build list of neighbor cells for each cell (including self)
 void getNeighborList(systemSI *pS) {
 
-    double cellSize = pS->cellSize;
     int nCells = pS->nCells;
-    int d = pS->d;
     int z = pS->z;
 
+    // Stencil of cells intersecting the cutoff disk
+    int *offsets = (int *)malloc(2 * z * sizeof(int));
+    assert(offsets != NULL);
+    int nStencil = cellStencil(pS->cellSize, pS->rc, offsets);
+    assert(nStencil == z);
+
     for (int cellIdx = 0; cellIdx < nCells * nCells; cellIdx++) {
         
         int i = cellIdx % nCells;
         int j = cellIdx / nCells;
 
-        int n = 0;
-        // Loop over 3x3 grid of neighboring cells
-        for (int dj = -1; dj <= 1; dj++) {
-            for (int di = -1; di <= 1; di++) {
+        for (int n = 0; n < z; n++) {
+            int si = i + offsets[2 * n + 0];
+            int sj = j + offsets[2 * n + 1];
 
-                // Apply periodic boundary conditions
-                int ni = (i + di + nCells) % nCells;
-                int nj = (j + dj + nCells) % nCells;
+            // Apply periodic boundary conditions
+            int ni = (si % nCells + nCells) % nCells;
+            int nj = (sj % nCells + nCells) % nCells;
 
-                pS->neighborCell[z * cellIdx + n] = ni + nj * nCells;
-                n++;
-            }
+            pS->neighborCell[z * cellIdx + n] = ni + nj * nCells;
+
+            // Shift that brings particles of the wrapped cell next to this one
+            pS->neighborShift[2 * (z * cellIdx + n) + 0] = ((si - ni) / nCells) * L_BOX;
+            pS->neighborShift[2 * (z * cellIdx + n) + 1] = ((sj - nj) / nCells) * L_BOX;
         }
     }
+
+    free(offsets);
 }
 
 
 // Update particle positions using Ornstein-Uhlenbeck process with periodic boundaries
 void iteration(systemSI *pS) {
     int d = pS->d;
-    double *x  = pS->x;
-    double *x0 = pS->x0;
-    double dt = pS->dt;
-    double *alpha = pS -> alpha;
-    double *sigma = pS -> sigma;
-    double L = L_BOX;
+    real *x  = pS->x;
+    real *x0 = pS->x0;
+    real L = L_BOX;
 
+    INSTR_BEGIN(PHASE_ITERATION);
 
-    // Update each particle position
-    for (int idx = 0; idx < N; idx++) {
-        
-        // Precompute OU process parameters
-        double exp_md = exp(-alpha[idx] * dt);
-        double tmp = 1.0 - exp(-2.0 * alpha[idx] * dt);
-        double var_factor = sigma[idx] * sqrt(tmp / (2.0 * alpha[idx]));
-        
-        int base_idx = d * idx;
-        
-        for (int mu = 0; mu < d; mu++) {
-            int pos = base_idx + mu;
-            
-            double cur = x[pos];
-            double eq  = x0[pos];
-            double z   = gasdev_mu_sigma(0.0, 1.0);
+    // Update each mobility class with its own OU coefficients
+    for (int c = 0; c < pS->nClasses; c++) {
+        const mobilityClass *mc = &pS->classes[c];
+        real exp_md = mc->expMd;
+        real var_factor = mc->varFactor;
+
+        for (int pos = d * mc->start; pos < d * mc->end; pos++) {
+            real cur = x[pos];
+            real eq  = x0[pos];
+            real z   = gasdev_mu_sigma(0.0, 1.0);
 
             // Use minimum image convention for periodic boundaries
-            double diff = minImage(cur, eq);
-            double newx = eq + diff * exp_md + var_factor * z;
+            real diff = minImage(cur, eq);
+            real newx = eq + diff * exp_md + var_factor * z;
 
             // Apply periodic boundary conditions (wrap around)
-            newx = fmod(newx, L);
-            if (newx < 0.0) newx += L;
+            newx = REAL_FMOD(newx, L);
+            if (newx < 0) newx += L;
 
             x[pos] = newx;
         }
     }
+
+    pS->step++;
+    INSTR_END(PHASE_ITERATION);
+    INSTR_ADD(steps, 1);
 }
 
 
-// Version 0: Independent state transitions (no spatial interactions)
-void propagation_v00(systemSI *pS, double beta, double lambda) {
-    // Copy current state to buffer
-    memcpy(pS->fakeState, pS->state, pS->memoryState);
+// Insert a scheduled particle in the bucket of its recovery step
+static void linkRecovery(recoveryWheel *w, int idx) {
+    int b = (int)(w->recoverAt[idx] & (RECOVERY_WHEEL - 1));
+    w->prev[idx] = -1;
+    w->next[idx] = w->head[b];
+    if (w->head[b] >= 0) w->prev[w->head[b]] = idx;
+    w->head[b] = idx;
+}
 
-    int *state     = pS->state;
-    int *fakeState = pS->fakeState;
-    double dt = pS->dt;
 
-    for (int idx = 0; idx < N; idx++) {
-        double r = uniform_pos();
+// Remove a particle from its bucket and clear its schedule
+static void unlinkRecovery(recoveryWheel *w, int idx) {
+    int b = (int)(w->recoverAt[idx] & (RECOVERY_WHEEL - 1));
+    if (w->prev[idx] >= 0) w->next[w->prev[idx]] = w->next[idx];
+    else w->head[b] = w->next[idx];
+    if (w->next[idx] >= 0) w->prev[w->next[idx]] = w->prev[idx];
+    w->recoverAt[idx] = -1;
+}
 
-        if (state[idx] == 0) {
-            // Infected -> Susceptible with rate lambda
-            fakeState[idx] = (r < lambda * dt) ? 1 : 0;
-        } else {
-            // Susceptible -> Infected with rate beta
-            fakeState[idx] = (r < beta * dt) ? 0 : 1;
-        }
-    }
 
-    // Update system state
-    memcpy(state, fakeState, pS->memoryState);
+// Schedule the recovery of a newly infected particle. The number of steps
+// until recovery is geometric with success probability p = rate*dt, the
+// same law as one Bernoulli(p) draw per step, but drawn once
+static void scheduleRecovery(systemSI *pS, int idx) {
+    recoveryWheel *w = &pS->wheel;
+    double p = w->rate * pS->dt;
+
+    if (w->recoverAt[idx] >= 0) unlinkRecovery(w, idx);
+    if (p <= 0.0) return;   // Never recovers
+
+    double wait = 1.0;
+    if (p < 1.0) wait += floor(log(uniform_pos()) / log1p(-p));
+    if (wait > 1e15) wait = 1e15;
+
+    w->recoverAt[idx] = w->now + (long)wait;
+    linkRecovery(w, idx);
 }
 
 
-// Version 1: Infection rate proportional to number of infected neighbors
-void propagation_v01(systemSI *pS, double beta, double lambda) {
+// Rebuild the buckets from the stored schedule (after loading or regrouping)
+void relinkRecoveries(systemSI *pS) {
+    recoveryWheel *w = &pS->wheel;
+    for (int b = 0; b < RECOVERY_WHEEL; b++) w->head[b] = -1;
+    for (int idx = 0; idx < N; idx++)
+        if (w->recoverAt[idx] >= 0) linkRecovery(w, idx);
+}
 
-    memcpy(pS->fakeState, pS->state, pS->memoryState);
-    
-    int *state     = pS->state;
-    int *fakeState = pS->fakeState;
-    
-    double dt = pS->dt;
-    double rc = pS->rc;
-    double L  = L_BOX;
-    
-    int d = pS->d;
-    int z = pS->z;
-    
-    double *x  = pS->x;
-    int nCells = pS->nCells;
-    
-    // Update cell lists
-    getCellIndex(pS);
-    
+
+// Draw a new schedule for every infected particle. Waiting times are
+// memoryless, so redrawing them at any step leaves the dynamics unchanged
+static void rescheduleRecoveries(systemSI *pS, double rate) {
+    recoveryWheel *w = &pS->wheel;
+    w->rate = rate;
+    w->dirty = 0;
+
+    for (int b = 0; b < RECOVERY_WHEEL; b++) w->head[b] = -1;
     for (int idx = 0; idx < N; idx++) {
-        double r = uniform_pos();
-        
-        if (state[idx] == 0) {
-            // Infected -> Susceptible with rate lambda
-            fakeState[idx] = (r < lambda * dt) ? 1 : 0;
-        } else {
-            // Susceptible: count infected neighbors
-            int num_infected_neighbors = 0;
-            
-            double xi = x[d * idx + 0];
-            double yi = x[d * idx + 1];
-            
-            // Find particle's cell
-            int ix = ((int)(xi / pS->cellSize)) % nCells;
-            int iy = ((int)(yi / pS->cellSize)) % nCells;
-            
-            if (ix < 0) ix += nCells;
-            if (iy < 0) iy += nCells;
-            
-            int cellIdx = iy * nCells + ix;
-            
-            // Search in neighboring cells only
-            for (int n = 0; n < z; n++) {
-                int neighborCellIdx = pS->neighborCell[z * cellIdx + n];
-                
-                for (int p = 0; p < pS->cellList[neighborCellIdx].nParticles; p++) {
-                    int jdx = pS->cellList[neighborCellIdx].particleIndex[p];
-                    
-                    if (jdx == idx) continue;
-                    if (state[jdx] != 0) continue; // Only count infected
-                    
-                    double xj = x[d * jdx + 0];
-                    double yj = x[d * jdx + 1];
-                    
-                    double dx = minImage(xi, xj);
-                    double dy = minImage(yi, yj);
-                    double dist_sq = dx*dx + dy*dy;
-                    
-                    if (dist_sq < rc*rc) {
-                        num_infected_neighbors++;
-                    }
-                }
+        w->recoverAt[idx] = -1;
+        if (pS->state[idx] == 0) scheduleRecovery(pS, idx);
+    }
+}
+
+
+static int compareInt(const void *a, const void *b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+
+// Advance the wheel by one step and recover (in fakeState) the particles
+// due now; only the current bucket is visited
+static void popRecoveries(systemSI *pS, double rate) {
+    recoveryWheel *w = &pS->wheel;
+    if (w->dirty || rate != w->rate) rescheduleRecoveries(pS, rate);
+
+    w->now++;
+    int nDue = 0;
+    int idx = w->head[w->now & (RECOVERY_WHEEL - 1)];
+    while (idx >= 0) {
+        int next = w->next[idx];
+        if (w->recoverAt[idx] == w->now) {
+            unlinkRecovery(w, idx);
+            if (pS->state[idx] == 0) {
+                pS->fakeState[idx] = 1;
+                w->due[nDue++] = idx;
             }
-            
-            // Infection probability proportional to infected neighbors
-            double infection_prob = 1.0 - exp(-beta * num_infected_neighbors * dt);
-            fakeState[idx] = (r < infection_prob) ? 0 : 1;
         }
+        idx = next;
+    }
+    w->nDue = nDue;
+
+    // Bucket order depends on history; record in slot order
+    if (pS->rec != NULL) {
+        qsort(w->due, nDue, sizeof(int), compareInt);
+        for (int k = 0; k < nDue; k++)
+            recordEvent(pS->rec, pS->step, EVENT_RECOVERY, pS->index[w->due[k]], -1, 0.0f);
     }
-    
-    memcpy(state, fakeState, pS->memoryState);
 }
 
 
-// Version 2: Distance-dependent infection probability exp(-lambda*r)
-void propagation_v02(systemSI *pS, double beta, double lambda) {
-    memcpy(pS->fakeState, pS->state, pS->memoryState);
-    
-    int *state     = pS->state;
-    int *fakeState = pS->fakeState;
-    double dt = pS->dt;
-    double rc = pS->rc;
+// Infector of a susceptible particle infected with uniform draw r, for the
+// event recorder. Neighbor j is chosen with probability p_j / sum p, p_j =
+// exp(-lambda r_j) dt its P(infection) alone. Given the infection r is
+// uniform on [0, P), P = 1 - prod (1 - p_j), so r / P picks j without an
+// extra draw. Two walks over the neighbor cells: totals, then the choice.
+static int attributeInfector(systemSI *pS, int idx, double r, double lambda, real *distance) {
     int d = pS->d;
     int z = pS->z;
-    double *x = pS->x;
     int nCells = pS->nCells;
-    
-    // Update cell lists
-    getCellIndex(pS);
-    
-    for (int idx = 0; idx < N; idx++) {
-        double r_random = uniform_pos();
-        
-        if (state[idx] == 0) {
-            // Infected -> Susceptible with rate beta (recovery)
-            fakeState[idx] = (r_random < beta * dt) ? 1 : 0;
-        } else {
-            // Susceptible: calculate probability of NOT being infected (product)
-            double prob_no_infection = 1.0;
-            
-            double xi = x[d * idx + 0];
-            double yi = x[d * idx + 1];
-            
-            // Find particle's cell
-            int ix = ((int)(xi / pS->cellSize)) % nCells;
-            int iy = ((int)(yi / pS->cellSize)) % nCells;
-            if (ix < 0) ix += nCells;
-            if (iy < 0) iy += nCells;
-            int cellIdx = iy * nCells + ix;
-            
-            // Search for infected neighbors
-            for (int n = 0; n < z; n++) {
-                int neighborCellIdx = pS->neighborCell[z * cellIdx + n];
-                
-                for (int p = 0; p < pS->cellList[neighborCellIdx].nParticles; p++) {
-                    int jdx = pS->cellList[neighborCellIdx].particleIndex[p];
-                    
-                    if (jdx == idx) continue;
-                    if (state[jdx] != 0) continue; // Only infected
-                    
-                    double xj = x[d * jdx + 0];
-                    double yj = x[d * jdx + 1];
-                    
-                    double dx = minImage(xi, xj);
-                    double dy = minImage(yi, yj);
-                    double dist = sqrt(dx*dx + dy*dy);
-                    
-                    if (dist < rc) {
-                        // P(this neighbor infects me) = exp(-lambda*r) * dt
-                        double p_infection_from_j = exp(-lambda * dist) * dt;
-                        
-                        // P(this neighbor does NOT infect me)
-                        double p_no_infection_from_j = 1.0 - p_infection_from_j;
-                        
-                        // Multiply in product
-                        prob_no_infection *= p_no_infection_from_j;
-                    }
+    real *x = pS->x;
+    real xi = x[d * idx + 0];
+    real yi = x[d * idx + 1];
+
+    int ix = ((int)(xi / pS->cellSize)) % nCells;
+    int iy = ((int)(yi / pS->cellSize)) % nCells;
+    if (ix < 0) ix += nCells;
+    if (iy < 0) iy += nCells;
+    int cellIdx = iy * nCells + ix;
+
+    double prob_no_infection = 1.0;
+    double sum = 0.0;
+    double target = 0.0;
+    int last = -1;
+    *distance = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        double partial = 0.0;
+
+        for (int n = 0; n < z; n++) {
+            int neighborCellIdx = pS->neighborCell[z * cellIdx + n];
+            real sx = pS->neighborShift[2 * (z * cellIdx + n) + 0] - xi;
+            real sy = pS->neighborShift[2 * (z * cellIdx + n) + 1] - yi;
+
+            for (int p = 0; p < pS->cellList[neighborCellIdx].nParticles; p++) {
+                int jdx = pS->cellList[neighborCellIdx].particleIndex[p];
+                if (jdx == idx || pS->state[jdx] != 0) continue;
+
+                real dx = x[d * jdx + 0] + sx;
+                real dy = x[d * jdx + 1] + sy;
+                real dist = REAL_SQRT(dx*dx + dy*dy);
+                if (dist >= pS->rc) continue;
+
+                double p_j = REAL_EXP(-(real)lambda * dist) * pS->dt;
+                if (pass == 0) {
+                    prob_no_infection *= 1.0 - p_j;
+                    sum += p_j;
+                    continue;
                 }
+
+                partial += p_j;
+                last = jdx;
+                *distance = dist;
+                if (target < partial) return jdx;
             }
-            
-            // P(infection) = 1 - P(no infection)
-            double infection_prob = 1.0 - prob_no_infection;
-            
-            fakeState[idx] = (r_random < infection_prob) ? 0 : 1;
         }
+
+        if (sum <= 0.0) return -1;
+        target = r / (1.0 - prob_no_infection) * sum;
     }
-    
-    memcpy(state, fakeState, pS->memoryState);
+
+    // Rounding left the target just above the sum: take the last neighbor
+    return last;
 }
 
 
-// Version 3: Distance-dependent infection probability exp(-lambda*r) with infected count
-// OPTIMIZED: Only search in neighbor cells of idx0
-int propagation_v03(systemSI *pS, double beta, double lambda) {
+// Attribute the infections of a synchronous update (version 2 and 5) for
+// the recorder and the offspring tracker; recoveries are handled by the wheel
+static void attributeInfections(systemSI *pS, double lambda, const double *draws) {
+    for (int idx = 0; idx < N; idx++) {
+        if (pS->state[idx] != 1 || pS->fakeState[idx] != 0) continue;
+
+        real dist;
+        int jdx = attributeInfector(pS, idx, draws[idx], lambda, &dist);
+        if (pS->rec != NULL)
+            recordEvent(pS->rec, pS->step, EVENT_INFECTION, pS->index[idx],
+                        jdx >= 0 ? pS->index[jdx] : -1, (float)dist);
+        if (pS->offspring != NULL)
+            offspringInfection(pS->offspring, idx, jdx);
+    }
+}
+
+
+// Close the infectious periods ended in this step, once its infections are
+// counted (particles reinfected in the same step were closed on infection)
+static void closeRecoveries(systemSI *pS) {
+    if (pS->offspring == NULL) return;
+
+    for (int k = 0; k < pS->wheel.nDue; k++) {
+        int idx = pS->wheel.due[k];
+        if (pS->fakeState[idx] == 1) offspringRecovery(pS->offspring, idx);
+    }
+}
+
+
+// Infection rules of the generic kernel (propagation_kernel.h)
+enum { RULE_SPONTANEOUS, RULE_COUNT, RULE_DISTANCE };
+
+// Version 0: Independent state transitions (no spatial interactions);
+// S -> I with rate beta, I -> S with rate lambda
+#define KERNEL_NAME       propagation_v00
+#define KERNEL_RULE       RULE_SPONTANEOUS
+#define KERNEL_SEARCH     SEARCH_NONE
+#define KERNEL_RECOVERY   lambda
+#define KERNEL_TRACK_FLAG 0
+#define KERNEL_COUNT      COUNT_NONE
+#include "propagation_kernel.h"
+
+
+// Version 1: Infection rate proportional to number of infected neighbors;
+// I -> S with rate lambda
+#define KERNEL_NAME       propagation_v01
+#define KERNEL_RULE       RULE_COUNT
+#define KERNEL_SEARCH     SEARCH_ALL
+#define KERNEL_RECOVERY   lambda
+#define KERNEL_TRACK_FLAG 0
+#define KERNEL_COUNT      COUNT_NONE
+#include "propagation_kernel.h"
+
+
+// Version 2: Distance-dependent infection probability exp(-lambda*r)
+#define KERNEL_NAME       propagation_v02
+#define KERNEL_RULE       RULE_DISTANCE
+#define KERNEL_SEARCH     SEARCH_ALL
+#define KERNEL_RECOVERY   beta
+#define KERNEL_TRACK_FLAG 0
+#define KERNEL_COUNT      COUNT_NONE
+#include "propagation_kernel.h"
+
+
+// Version 3: as version 2, searching only the neighbor cells of idx0;
+// returns the number of infected particles
+#define KERNEL_NAME       propagation_v03
+#define KERNEL_RULE       RULE_DISTANCE
+#define KERNEL_SEARCH     SEARCH_IDX0
+#define KERNEL_RECOVERY   beta
+#define KERNEL_TRACK_FLAG 0
+#define KERNEL_COUNT      COUNT_INFECTED
+#include "propagation_kernel.h"
+
+
+// Version 4: as version 3, marking flag[i] on infection; returns the number
+// of particles ever infected (each counted once)
+#define KERNEL_NAME       propagation_v04
+#define KERNEL_RULE       RULE_DISTANCE
+#define KERNEL_SEARCH     SEARCH_IDX0
+#define KERNEL_RECOVERY   beta
+#define KERNEL_TRACK_FLAG 1
+#define KERNEL_COUNT      COUNT_EVER
+#include "propagation_kernel.h"
+
+
+// Version 5: same model as version 2, but pair-centric. Each unordered pair is
+// visited once, over the home cell and the forward half of the stencil (the
+// stencil is lexicographic, so the home cell sits at (z-1)/2 and its forward
+// neighbors follow). Each S-I pair within rc multiplies the susceptible's
+// P(no infection); states are then drawn in the same order as version 2.
+int propagation_v05(systemSI *pS, double beta, double lambda) {
     memcpy(pS->fakeState, pS->state, pS->memoryState);
-    
+
     int *state     = pS->state;
     int *fakeState = pS->fakeState;
+    double *noInfection = pS->noInfection;
     double dt = pS->dt;
-    double rc = pS->rc;
+    real rc = pS->rc;
     int d = pS->d;
     int z = pS->z;
-    double *x = pS->x;
+    int zHome = (z - 1) / 2;
+    real *x = pS->x;
     int nCells = pS->nCells;
-    int idx0 = pS->idx0;
-    
+
     // Update cell lists
     getCellIndex(pS);
-    
-    // Step 1: Update recovery for all infected particles
+
+    INSTR_BEGIN(PHASE_PROPAGATION);
+
     for (int idx = 0; idx < N; idx++) {
-        if (state[idx] == 0) {
-            // Infected -> Susceptible with rate beta (recovery)
-            double r_random = uniform_pos();
-            fakeState[idx] = (r_random < beta * dt) ? 1 : 0;
-        }
+        noInfection[idx] = 1.0;
     }
-    
-    // Step 2: Find idx0's cell
-    double x0 = x[d * idx0 + 0];
-    double y0 = x[d * idx0 + 1];
-    
-    int ix0 = ((int)(x0 / pS->cellSize)) % nCells;
-    int iy0 = ((int)(y0 / pS->cellSize)) % nCells;
-    if (ix0 < 0) ix0 += nCells;
-    if (iy0 < 0) iy0 += nCells;
-    int cellIdx0 = iy0 * nCells + ix0;
-    
-    // Step 3: Search only in neighbor cells of idx0
-    if (state[idx0] == 0) {  // Only if idx0 is infected
-        for (int n = 0; n < z; n++) {
-            int neighborCellIdx = pS->neighborCell[z * cellIdx0 + n];
-            
-            for (int p = 0; p < pS->cellList[neighborCellIdx].nParticles; p++) {
-                int idx = pS->cellList[neighborCellIdx].particleIndex[p];
-                
-                if (idx == idx0) continue;              // Skip idx0 itself
-                if (fakeState[idx] != 1) continue;      // Only susceptibles (state == 1)
-                
-                // Calculate distance
-                double xi = x[d * idx + 0];
-                double yi = x[d * idx + 1];
-                double dx = minImage(x0, xi);
-                double dy = minImage(y0, yi);
-                double dist = sqrt(dx*dx + dy*dy);
-                
-                if (dist < rc) {
-                    // P(infection) = exp(-lambda*r) * dt
-                    double infection_prob = exp(-lambda * dist) * dt;
-                    double r_random = uniform_pos();
-                    
-                    if (r_random < infection_prob) {
-                        fakeState[idx] = 0;  // Becomes infected
+
+    // Accumulate infection contributions pair by pair
+    for (int cellIdx = 0; cellIdx < nCells * nCells; cellIdx++) {
+        cell *home = &pS->cellList[cellIdx];
+
+        for (int n = zHome; n < z; n++) {
+            cell *other = &pS->cellList[pS->neighborCell[z * cellIdx + n]];
+            real shiftX = pS->neighborShift[2 * (z * cellIdx + n) + 0];
+            real shiftY = pS->neighborShift[2 * (z * cellIdx + n) + 1];
+
+            for (int a = 0; a < home->nParticles; a++) {
+                int idx = home->particleIndex[a];
+                int si = state[idx];
+                real sx = shiftX - x[d * idx + 0];
+                real sy = shiftY - x[d * idx + 1];
+
+                // Within the home cell, only pairs (a, b > a)
+                int start = (n == zHome) ? a + 1 : 0;
+
+                for (int b = start; b < other->nParticles; b++) {
+                    int jdx = other->particleIndex[b];
+
+                    INSTR_ADD(pairCandidates, 1);
+                    if (state[jdx] == si) continue;   // Only S-I pairs
+
+                    real dx = x[d * jdx + 0] + sx;
+                    real dy = x[d * jdx + 1] + sy;
+                    real dist = REAL_SQRT(dx*dx + dy*dy);
+
+                    if (dist < rc) {
+                        INSTR_ADD(pairsInRange, 1);
+
+                        // P(infected neighbor does NOT infect the susceptible one)
+                        int sus = si ? idx : jdx;
+                        noInfection[sus] *= 1.0 - REAL_EXP(-(real)lambda * dist) * dt;
                     }
                 }
             }
         }
     }
-    
-    memcpy(state, fakeState, pS->memoryState);
-    
-    // Count infected particles (state == 0)
-    int nInfected = 0;
+
+    // Infected -> Susceptible with rate beta (scheduled recovery)
+    popRecoveries(pS, beta);
+
     for (int idx = 0; idx < N; idx++) {
-        if (state[idx] == 0) {
-            nInfected++;
+        if (state[idx] == 0) continue;
+
+        // P(infection) = 1 - P(no infection)
+        double r_random = uniform_pos();
+        if (r_random < 1.0 - noInfection[idx]) {
+            fakeState[idx] = 0;
+            scheduleRecovery(pS, idx);
         }
+        noInfection[idx] = r_random;   // Product no longer needed, kept for attribution
     }
-    
-    return nInfected;
+
+    if (pS->rec != NULL || pS->offspring != NULL) attributeInfections(pS, lambda, noInfection);
+    closeRecoveries(pS);
+    memcpy(state, fakeState, pS->memoryState);
+    INSTR_END(PHASE_PROPAGATION);
+    return 0;
 }
 
 
-// Version 3: Distance-dependent infection probability exp(-lambda*r)
-// OPTIMIZED: Only search in neighbor cells of idx0
-// Uses flag[i] to count each particle only once (no reinfection counts)
-int propagation_v04(systemSI *pS, double beta, double lambda) {
-    memcpy(pS->fakeState, pS->state, pS->memoryState);
-    
-    int *state     = pS->state;
-    int *fakeState = pS->fakeState;
-    int *flag      = pS->flag;      // Track if particle was ever infected (0=never, 1=ever)
-    double dt = pS->dt;
-    double rc = pS->rc;
+// Runtime selection of the kernels (-v in main, meassure and move)
+const kernelInfo propagationKernels[] = {
+    {"v00", propagation_v00, SEARCH_NONE,  COUNT_NONE,     0, 0, "independent S <-> I transitions"},
+    {"v01", propagation_v01, SEARCH_ALL,   COUNT_NONE,     0, 0, "rate proportional to infected neighbors"},
+    {"v02", propagation_v02, SEARCH_ALL,   COUNT_NONE,     0, 1, "distance-dependent exp(-lambda r)"},
+    {"v03", propagation_v03, SEARCH_IDX0,  COUNT_INFECTED, 0, 1, "v02 model, idx0 infects alone"},
+    {"v04", propagation_v04, SEARCH_IDX0,  COUNT_EVER,     1, 1, "v03, ever-infected tracking (R0)"},
+    {"v05", propagation_v05, SEARCH_PAIRS, COUNT_NONE,     0, 1, "v02 model, each pair visited once"},
+};
+const int nPropagationKernels = sizeof(propagationKernels) / sizeof(propagationKernels[0]);
+
+
+// Kernel by name ("v02" or "2"), NULL if unknown
+const kernelInfo *findKernel(const char *name) {
+    char *end;
+    long version = strtol(name, &end, 10);
+    int bare = (end != name && *end == '\0');
+
+    for (int k = 0; k < nPropagationKernels; k++) {
+        const char *kernelName = propagationKernels[k].name;
+        if (strcmp(kernelName, name) == 0 || (bare && atol(kernelName + 1) == version))
+            return &propagationKernels[k];
+    }
+    return NULL;
+}
+
+
+// One line per kernel (usage messages)
+void printKernels(FILE *fp) {
+    for (int k = 0; k < nPropagationKernels; k++)
+        fprintf(fp, "  %s  %s\n", propagationKernels[k].name, propagationKernels[k].description);
+}
+
+
+// One R0 realization, as in meassure: version 4 from the current state until
+// idx0 recovers (or after maxSteps + 1 steps). Returns the number of particles
+// ever infected, idx0 included (R0 + 1), and the steps taken in *steps
+int measureR0(systemSI *pS, double beta, double lambda, long maxSteps, long *steps) {
+    int idx0 = pS->idx0;
+    int r0 = 0;
+    long step;
+    for (step = 0; step <= maxSteps && !pS->state[idx0]; step++) {
+        iteration(pS);                          // Update particle positions
+        getCellIndex(pS);                       // Update cell lists
+        r0 = propagation_v04(pS, beta, lambda);
+    }
+    if (steps != NULL) *steps = step;
+    return r0;
+}
+
+
+// Root of a particle's tree, halving the path on the way (roots hold -size)
+static int findCluster(int *parent, int idx) {
+    while (parent[idx] >= 0) {
+        if (parent[parent[idx]] >= 0) parent[idx] = parent[parent[idx]];
+        idx = parent[idx];
+    }
+    return idx;
+}
+
+
+// Label the clusters of infected particles (connected when closer than rc)
+// with a union-find over the neighbor cells, linking the smaller tree under
+// the larger. Afterwards pS->cluster holds the root particle of each infected
+// particle (-1 for susceptibles). Returns the number of clusters; sizeCount
+// (N + 1 entries, may be NULL) receives the number of clusters of each size
+// and largest (may be NULL) the size of the largest one.
+int labelClusters(systemSI *pS, int *sizeCount, int *largest) {
+    int *state = pS->state;
+    int *parent = pS->cluster;
+    real *x = pS->x;
+    real rc = pS->rc;
     int d = pS->d;
     int z = pS->z;
-    double *x = pS->x;
     int nCells = pS->nCells;
-    int idx0 = pS->idx0;
-    
-    // Update cell lists
-    getCellIndex(pS);
-    
-    // Step 1: Update recovery for all infected particles
+
+    for (int idx = 0; idx < N; idx++) parent[idx] = -1;
+
     for (int idx = 0; idx < N; idx++) {
-        if (state[idx] == 0) {
-            // Infected -> Susceptible with rate beta (recovery)
-            double r_random = uniform_pos();
-            fakeState[idx] = (r_random < beta * dt) ? 1 : 0;
-        }
-    }
-    
-    // Step 2: Find idx0's cell
-    double x0 = x[d * idx0 + 0];
-    double y0 = x[d * idx0 + 1];
-    
-    int ix0 = ((int)(x0 / pS->cellSize)) % nCells;
-    int iy0 = ((int)(y0 / pS->cellSize)) % nCells;
-    if (ix0 < 0) ix0 += nCells;
-    if (iy0 < 0) iy0 += nCells;
-    int cellIdx0 = iy0 * nCells + ix0;
-    
-    // Step 3: Search only in neighbor cells of idx0
-    if (state[idx0] == 0) {  // Only if idx0 is infected
+        if (state[idx] != 0) continue;
+
+        real xi = x[d * idx + 0];
+        real yi = x[d * idx + 1];
+        int ix = ((int)(xi / pS->cellSize)) % nCells;
+        int iy = ((int)(yi / pS->cellSize)) % nCells;
+        if (ix < 0) ix += nCells;
+        if (iy < 0) iy += nCells;
+        int cellIdx = iy * nCells + ix;
+
         for (int n = 0; n < z; n++) {
-            int neighborCellIdx = pS->neighborCell[z * cellIdx0 + n];
-            
+            int neighborCellIdx = pS->neighborCell[z * cellIdx + n];
+            real sx = pS->neighborShift[2 * (z * cellIdx + n) + 0] - xi;
+            real sy = pS->neighborShift[2 * (z * cellIdx + n) + 1] - yi;
+
             for (int p = 0; p < pS->cellList[neighborCellIdx].nParticles; p++) {
-                int idx = pS->cellList[neighborCellIdx].particleIndex[p];
-                
-                if (idx == idx0) continue;              // Skip idx0 itself
-                if (fakeState[idx] != 1) continue;      // Only susceptibles (state == 1)
-                
-                // Calculate distance
-                double xi = x[d * idx + 0];
-                double yi = x[d * idx + 1];
-                double dx = minImage(x0, xi);
-                double dy = minImage(y0, yi);
-                double dist = sqrt(dx*dx + dy*dy);
-                
-                if (dist < rc) {
-                    // P(infection) = exp(-lambda*r) * dt
-                    double infection_prob = exp(-lambda * dist) * dt;
-                    double r_random = uniform_pos();
-                    
-                    if (r_random < infection_prob) {
-                        fakeState[idx] = 0;              // Becomes infected (state = 0)
-                        flag[idx] = 1;                   // Mark: this particle was EVER infected
-                    }
-                }
+                int jdx = pS->cellList[neighborCellIdx].particleIndex[p];
+
+                // Each pair once
+                if (jdx >= idx || state[jdx] != 0) continue;
+
+                real dx = x[d * jdx + 0] + sx;
+                real dy = x[d * jdx + 1] + sy;
+                if (dx * dx + dy * dy >= rc * rc) continue;
+
+                int a = findCluster(parent, idx);
+                int b = findCluster(parent, jdx);
+                if (a == b) continue;
+                if (parent[a] > parent[b]) { int t = a; a = b; b = t; }
+                parent[a] += parent[b];
+                parent[b] = a;
             }
         }
     }
-    
-    memcpy(state, fakeState, pS->memoryState);
-    
-    // Return: count total particles that were EVER infected (cumulative, no reinfection counts)
-    int nInfected = 0;
+
+    // Sizes are read from the roots before they are relabeled
+    int nClusters = 0, maxSize = 0;
+    if (sizeCount != NULL) memset(sizeCount, 0, (N + 1) * sizeof(int));
     for (int idx = 0; idx < N; idx++) {
-        if (flag[idx] == 1) {        // Count only if ever been infected
-            nInfected++;
-        }
+        if (state[idx] != 0 || parent[idx] >= 0) continue;
+        int size = -parent[idx];
+        nClusters++;
+        if (size > maxSize) maxSize = size;
+        if (sizeCount != NULL) sizeCount[size]++;
     }
-    
-    return nInfected;
+
+    for (int idx = 0; idx < N; idx++)
+        if (state[idx] == 0 && parent[idx] >= 0) parent[idx] = findCluster(parent, idx);
+    for (int idx = 0; idx < N; idx++)
+        if (state[idx] != 0) parent[idx] = -1;
+        else if (parent[idx] < 0) parent[idx] = idx;
+
+    if (largest != NULL) *largest = maxSize;
+    return nClusters;
 }
 
 
 // Compute minimum image distance for periodic boundary conditions
-double minImage(double xi, double xj){
-    double xij = xi - xj;
-    return xij - L_BOX * round(xij / L_BOX); 
+real minImage(real xi, real xj){
+    real xij = xi - xj;
+    return xij - (real)L_BOX * REAL_ROUND(xij / (real)L_BOX); 
 }
 
 
@@ -601,7 +866,8 @@ void resetInfection(systemSI *pS) {
         pS -> state[idx] = 1;
         pS -> flag[idx] = 0; 
     }
-    
+    pS->wheel.dirty = 1;
+
 }
 
 void uniformSigma(systemSI *pS, double sigma) {
@@ -609,14 +875,42 @@ void uniformSigma(systemSI *pS, double sigma) {
     for (int idx = 0; idx < N; idx++) {
         pS -> sigma[idx] = sigma; 
     }
+    groupMobilityClasses(pS);
 }
 
 
-void randomGaussianSigma(systemSI *pS, double meanSigma) {
+// Positive Gaussian draw (mean, std 1) quantized into MOBILITY_CLASSES bins
+// spanning [max(mean - 3, 0), mean + 3]; each value is its bin center.
+// Draws <= 0 are rejected, at most half of them for mean >= 0 (checked by
+// the callers)
+static double quantizedGaussian(double mean) {
+    double lo = (mean > 3.0) ? mean - 3.0 : 0.0;
+    double hi = mean + 3.0;
+    double width = (hi - lo) / MOBILITY_CLASSES;
+
+    double value;
+    do {
+        value = gasdev_mu_sigma(mean, 1.0);
+    } while (value <= 0.0);
+
+    int bin = (int)((value - lo) / width);
+    if (bin < 0) bin = 0;
+    if (bin >= MOBILITY_CLASSES) bin = MOBILITY_CLASSES - 1;
+    return lo + (bin + 0.5) * width;
+}
+
+
+int randomGaussianSigma(systemSI *pS, double meanSigma) {
 
+    if (!(meanSigma >= 0.0)) {
+        fprintf(stderr, "randomGaussianSigma: mean %g must be >= 0\n", meanSigma);
+        return -1;
+    }
     for (int idx = 0; idx < N; idx++) {
-        pS -> sigma[idx] = gasdev_mu_sigma(meanSigma, 1.0);
+        pS -> sigma[idx] = quantizedGaussian(meanSigma);
     }
+    groupMobilityClasses(pS);
+    return 0;
 }
 
 
@@ -625,16 +919,126 @@ void uniformAlpha(systemSI *pS, double alpha) {
     for (int idx = 0; idx < N; idx++) {
         pS -> alpha[idx] = alpha; 
     }
+    groupMobilityClasses(pS);
 }
 
 
-void randomGaussianAlpha(systemSI *pS, double meanAlpha) {
+int randomGaussianAlpha(systemSI *pS, double meanAlpha) {
 
+    if (!(meanAlpha >= 0.0)) {
+        fprintf(stderr, "randomGaussianAlpha: mean %g must be >= 0\n", meanAlpha);
+        return -1;
+    }
     for (int idx = 0; idx < N; idx++) {
-        pS -> alpha[idx] = gasdev_mu_sigma(meanAlpha, 1.0);
+        pS -> alpha[idx] = quantizedGaussian(meanAlpha);
     }
+    groupMobilityClasses(pS);
+    return 0;
 }
 
+
+// Sort key of a particle: its OU parameters, then its current slot
+typedef struct {
+    double alpha, sigma;
+    int slot;
+} mobilityKey;
+
+static int compareMobility(const void *a, const void *b) {
+    const mobilityKey *p = (const mobilityKey *)a;
+    const mobilityKey *q = (const mobilityKey *)b;
+    if (p->alpha != q->alpha) return (p->alpha > q->alpha) - (p->alpha < q->alpha);
+    if (p->sigma != q->sigma) return (p->sigma > q->sigma) - (p->sigma < q->sigma);
+    return p->slot - q->slot;
+}
+
+
+// Apply the permutation (slot k receives old slot perm[k]) to one array
+static void permuteArray(void *array, void *tmp, const int *perm, size_t size) {
+    char *a = (char *)array;
+    char *t = (char *)tmp;
+    memcpy(t, a, N * size);
+    for (int k = 0; k < N; k++)
+        memcpy(a + k * size, t + perm[k] * size, size);
+}
+
+
+// Store particles grouped by (alpha, sigma) and recompute the per-class
+// OU coefficients. Particles keep their positions, tethers and states; the
+// original label of each slot stays in pS->index and idx0 follows its
+// particle. Cell lists are rebuilt if any particle moved.
+void groupMobilityClasses(systemSI *pS) {
+    int d = pS->d;
+    double dt = pS->dt;
+
+    mobilityKey *keys = (mobilityKey *)malloc(N * sizeof(mobilityKey));
+    int *perm = (int *)malloc(N * sizeof(int));
+    assert(keys != NULL && perm != NULL);
+
+    for (int i = 0; i < N; i++)
+        keys[i] = (mobilityKey){pS->alpha[i], pS->sigma[i], i};
+    qsort(keys, N, sizeof(mobilityKey), compareMobility);
+
+    int moved = 0;
+    for (int k = 0; k < N; k++) {
+        perm[k] = keys[k].slot;
+        moved |= (perm[k] != k);
+    }
+
+    if (moved) {
+        void *tmp = malloc(pS->memoryX);
+        assert(tmp != NULL);
+        permuteArray(pS->x,         tmp, perm, d * sizeof(real));
+        permuteArray(pS->x0,        tmp, perm, d * sizeof(real));
+        permuteArray(pS->alpha,     tmp, perm, sizeof(real));
+        permuteArray(pS->sigma,     tmp, perm, sizeof(real));
+        permuteArray(pS->index,     tmp, perm, sizeof(int));
+        permuteArray(pS->state,     tmp, perm, sizeof(int));
+        permuteArray(pS->fakeState, tmp, perm, sizeof(int));
+        permuteArray(pS->flag,      tmp, perm, sizeof(int));
+        permuteArray(pS->wheel.recoverAt, tmp, perm, sizeof(long));
+        if (pS->offspring != NULL) {
+            permuteArray(pS->offspring->generation, tmp, perm, sizeof(int));
+            permuteArray(pS->offspring->offspring,  tmp, perm, sizeof(int));
+        }
+        free(tmp);
+        relinkRecoveries(pS);
+
+        for (int k = 0; k < N; k++)
+            if (perm[k] == pS->idx0) { pS->idx0 = k; break; }
+        getCellIndex(pS);
+    }
+
+    // One class per run of equal parameters
+    int maxClasses = MOBILITY_CLASSES * MOBILITY_CLASSES;
+    pS->nClasses = 0;
+    for (int k = 0; k < N; k++) {
+        if (k > 0 && keys[k].alpha == keys[k - 1].alpha && keys[k].sigma == keys[k - 1].sigma) {
+            pS->classes[pS->nClasses - 1].end = k + 1;
+            continue;
+        }
+        assert(pS->nClasses < maxClasses);
+
+        double alpha = keys[k].alpha;
+        double sigma = keys[k].sigma;
+        mobilityClass *mc = &pS->classes[pS->nClasses++];
+        mc->start = k;
+        mc->end = k + 1;
+        mc->alpha = alpha;
+        mc->sigma = sigma;
+        if (alpha > 0.0) {
+            mc->expMd = exp(-alpha * dt);
+            mc->varFactor = sigma * sqrt((1.0 - exp(-2.0 * alpha * dt)) / (2.0 * alpha));
+        } else {
+            mc->expMd = 1.0;                // Free diffusion
+            mc->varFactor = sigma * sqrt(dt);
+        }
+    }
+
+    free(keys);
+    free(perm);
+}
+
+
 // Debug function: verify particle assignment to cells
 void verifyParticlesInCells(systemSI *pS) {
     printf("\n=== VERIFICATION: PARTICLES PER CELL ===\n\n");
@@ -0,0 +1,423 @@
+#include <unistd.h>
+#include "config.h"
+#include "system.h"
+#include "trajectory.h"
+
+// Worst-case encoded size of one coordinate (32-bit varint)
+#define MAX_VARINT 5
+
+
+// Quantize a coordinate in [0, L) onto the 2^bits grid
+static unsigned int quantize(double x, double L, int bits) {
+    unsigned int mask = (bits == 32) ? 0xFFFFFFFFu : ((1u << bits) - 1u);
+    double q = floor(x / L * ldexp(1.0, bits));
+    if (q < 0.0) q = 0.0;
+    return (unsigned int)(long long)q & mask;
+}
+
+
+// Position of the center of a grid point
+static double dequantize(unsigned int q, double L, int bits) {
+    return ((double)q + 0.5) * L / ldexp(1.0, bits);
+}
+
+
+// Signed periodic difference q - ref on the 2^bits grid, zigzag-encoded
+static unsigned int encodeDelta(unsigned int q, unsigned int ref, int bits) {
+    unsigned int mask = (bits == 32) ? 0xFFFFFFFFu : ((1u << bits) - 1u);
+    unsigned int u = (q - ref) & mask;
+    int delta = (u & (1u << (bits - 1))) ? (int)(u | ~mask) : (int)u;
+    return ((unsigned int)delta << 1) ^ (unsigned int)(delta >> 31);
+}
+
+
+// Inverse of encodeDelta
+static unsigned int decodeDelta(unsigned int zz, unsigned int ref, int bits) {
+    unsigned int mask = (bits == 32) ? 0xFFFFFFFFu : ((1u << bits) - 1u);
+    int delta = (int)(zz >> 1) ^ -(int)(zz & 1u);
+    return (ref + (unsigned int)delta) & mask;
+}
+
+
+// Append a LEB128 varint to buffer, return bytes written
+static int putVarint(unsigned char *buffer, unsigned int v) {
+    int n = 0;
+    while (v >= 0x80) {
+        buffer[n++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    buffer[n++] = (unsigned char)v;
+    return n;
+}
+
+
+// Read a LEB128 varint from buffer, return bytes consumed
+static int getVarint(const unsigned char *buffer, unsigned int *v) {
+    unsigned int result = 0;
+    int shift = 0, n = 0;
+    unsigned char byte;
+    do {
+        byte = buffer[n++];
+        result |= (unsigned int)(byte & 0x7F) << shift;
+        shift += 7;
+    } while ((byte & 0x80) && n < MAX_VARINT);
+    *v = result;
+    return n;
+}
+
+
+// =======================================================
+//   Writer
+// =======================================================
+
+// Continue a trajectory file written for the same system: keep the frames
+// before the current step, drop the rest (written after the last
+// checkpoint) and restore the reference of the next delta frame
+static int resumeTrajectory(trajectoryWriter *tw, const char *filename, systemSI *pS) {
+
+    trajectoryReader *tr = openTrajectoryReader(filename);
+    if (tr == NULL) return -1;
+    if (tr->h.n != N || tr->h.d != pS->d || tr->h.bits != tw->h.bits) {
+        fprintf(stderr, "openTrajectory: %s: not a trajectory of this system\n", filename);
+        closeTrajectoryReader(tr);
+        return -1;
+    }
+
+    int nCoord = N * pS->d;
+    tw->h = tr->h;
+    memcpy(tw->q0, tr->q0, nCoord * sizeof(unsigned int));
+
+    // Frames are written in step order
+    long kept = 0;
+    long long cut = sizeof(trajectoryHeader) + (long long)nCoord * sizeof(unsigned int);
+    frameHeader fh;
+    while (kept < tr->nFrames) {
+        fseeko(tr->fp, tr->offsets[kept], SEEK_SET);
+        if (fread(&fh, sizeof(frameHeader), 1, tr->fp) != 1 || fh.step >= pS->step) break;
+        cut = tr->offsets[kept] + sizeof(frameHeader) + fh.size;
+        kept++;
+    }
+    if (kept > 0 && readFrame(tr, kept - 1, NULL, NULL, NULL) != 0) {
+        fprintf(stderr, "openTrajectory: %s: cannot read frame %ld\n", filename, kept - 1);
+        closeTrajectoryReader(tr);
+        return -1;
+    }
+    memcpy(tw->q, tr->q, nCoord * sizeof(unsigned int));
+
+    while (tw->capFrames < kept) tw->capFrames *= 2;
+    tw->offsets = (long long *)realloc(tw->offsets, tw->capFrames * sizeof(long long));
+    assert(tw->offsets != NULL);
+    memcpy(tw->offsets, tr->offsets, kept * sizeof(long long));
+    tw->nFrames = kept;
+    closeTrajectoryReader(tr);
+
+    // The index (if any) lies after the kept frames and is rewritten on close
+    tw->fp = fopen(filename, "r+b");
+    if (tw->fp == NULL || ftruncate(fileno(tw->fp), cut) != 0) {
+        fprintf(stderr, "openTrajectory: cannot truncate %s\n", filename);
+        return -1;
+    }
+    fseeko(tw->fp, cut, SEEK_SET);
+    return 0;
+}
+
+
+// Create a trajectory file (bits per coordinate, frames between keyframes),
+// or continue an existing one up to the current step if append is set
+trajectoryWriter *openTrajectory(const char *filename, systemSI *pS, int bits, int keyEvery, int append) {
+
+    assert(bits >= 2 && bits <= 32);
+    assert(keyEvery >= 1);
+
+    trajectoryWriter *tw = (trajectoryWriter *)calloc(1, sizeof(trajectoryWriter));
+    assert(tw != NULL);
+
+    int nCoord = N * pS->d;
+
+    memcpy(tw->h.magic, TRAJECTORY_MAGIC, sizeof(TRAJECTORY_MAGIC));
+    tw->h.version  = TRAJECTORY_VERSION;
+    tw->h.n        = N;
+    tw->h.d        = pS->d;
+    tw->h.bits     = bits;
+    tw->h.keyEvery = keyEvery;
+    tw->h.lBox     = L_BOX;
+    tw->h.dt       = pS->dt;
+
+    tw->q      = (unsigned int *)malloc(nCoord * sizeof(unsigned int));
+    tw->q0     = (unsigned int *)malloc(nCoord * sizeof(unsigned int));
+    tw->buffer = (unsigned char *)malloc((size_t)nCoord * MAX_VARINT + (N + 7) / 8);
+    assert(tw->q != NULL && tw->q0 != NULL && tw->buffer != NULL);
+
+    tw->capFrames = 1024;
+    tw->offsets = (long long *)malloc(tw->capFrames * sizeof(long long));
+    assert(tw->offsets != NULL);
+
+    if (append && access(filename, F_OK) == 0) {
+        if (resumeTrajectory(tw, filename, pS) == 0) return tw;
+        if (tw->fp != NULL) fclose(tw->fp);
+        tw->fp = NULL;
+        closeTrajectory(tw);
+        return NULL;
+    }
+
+    tw->fp = fopen(filename, "wb");
+    if (tw->fp == NULL) {
+        fprintf(stderr, "openTrajectory: cannot open %s\n", filename);
+        closeTrajectory(tw);
+        return NULL;
+    }
+
+    // Equilibrium positions are stored once and used as keyframe reference
+    for (int k = 0; k < nCoord; k++)
+        tw->q0[k] = quantize(pS->x0[k], L_BOX, bits);
+
+    fwrite(&tw->h, sizeof(trajectoryHeader), 1, tw->fp);
+    fwrite(tw->q0, sizeof(unsigned int), nCoord, tw->fp);
+
+    return tw;
+}
+
+
+// Append the current positions and states as a new frame
+int writeFrame(trajectoryWriter *tw, systemSI *pS) {
+
+    int nCoord = tw->h.n * tw->h.d;
+    int bits = tw->h.bits;
+    int keyframe = (tw->nFrames % tw->h.keyEvery) == 0;
+    unsigned int *ref = keyframe ? tw->q0 : tw->q;
+
+    // Delta-encode positions
+    size_t size = 0;
+    for (int k = 0; k < nCoord; k++) {
+        unsigned int q = quantize(pS->x[k], L_BOX, bits);
+        size += putVarint(tw->buffer + size, encodeDelta(q, ref[k], bits));
+        tw->q[k] = q;
+    }
+
+    // Bit-pack states
+    unsigned char *packed = tw->buffer + size;
+    memset(packed, 0, (tw->h.n + 7) / 8);
+    for (int i = 0; i < tw->h.n; i++)
+        if (pS->state[i]) packed[i >> 3] |= (unsigned char)(1u << (i & 7));
+    size += (tw->h.n + 7) / 8;
+
+    // Record frame offset
+    if (tw->nFrames == tw->capFrames) {
+        tw->capFrames *= 2;
+        tw->offsets = (long long *)realloc(tw->offsets, tw->capFrames * sizeof(long long));
+        assert(tw->offsets != NULL);
+    }
+    tw->offsets[tw->nFrames++] = (long long)ftello(tw->fp);
+
+    frameHeader fh = {pS->step, (unsigned int)size, keyframe};
+    if (fwrite(&fh, sizeof(frameHeader), 1, tw->fp) != 1 ||
+        fwrite(tw->buffer, 1, size, tw->fp) != size) {
+        fprintf(stderr, "writeFrame: write error\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+// Write the frame index and close the file
+void closeTrajectory(trajectoryWriter *tw) {
+    if (tw == NULL)
+        return;
+
+    // Without a file (failed open) only the memory is released
+    if (tw->fp != NULL) {
+        long long nFrames = tw->nFrames;
+        fwrite(tw->offsets, sizeof(long long), tw->nFrames, tw->fp);
+        fwrite(&nFrames, sizeof(long long), 1, tw->fp);
+        fwrite(TRAJECTORY_INDEX_MAGIC, 1, sizeof(TRAJECTORY_INDEX_MAGIC), tw->fp);
+        fclose(tw->fp);
+    }
+
+    free(tw->q);
+    free(tw->q0);
+    free(tw->buffer);
+    free(tw->offsets);
+    free(tw);
+}
+
+
+// =======================================================
+//   Reader
+// =======================================================
+
+// Rebuild the frame index by walking the frames (file without index)
+static long scanFrames(trajectoryReader *tr, long long start, long long end) {
+    long cap = 1024;
+    tr->offsets = (long long *)malloc(cap * sizeof(long long));
+    assert(tr->offsets != NULL);
+
+    long n = 0;
+    long long offset = start;
+    frameHeader fh;
+    fseeko(tr->fp, offset, SEEK_SET);
+    while (offset + (long long)sizeof(frameHeader) <= end &&
+           fread(&fh, sizeof(frameHeader), 1, tr->fp) == 1) {
+        long long next = offset + sizeof(frameHeader) + fh.size;
+        if (next > end) break;   // truncated last frame
+        if (n == cap) {
+            cap *= 2;
+            tr->offsets = (long long *)realloc(tr->offsets, cap * sizeof(long long));
+            assert(tr->offsets != NULL);
+        }
+        tr->offsets[n++] = offset;
+        offset = next;
+        fseeko(tr->fp, offset, SEEK_SET);
+    }
+    return n;
+}
+
+
+// Open a trajectory file for random access
+trajectoryReader *openTrajectoryReader(const char *filename) {
+
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "openTrajectoryReader: cannot open %s\n", filename);
+        return NULL;
+    }
+
+    trajectoryReader *tr = (trajectoryReader *)calloc(1, sizeof(trajectoryReader));
+    assert(tr != NULL);
+    tr->fp = fp;
+    tr->current = -1;
+
+    if (fread(&tr->h, sizeof(trajectoryHeader), 1, fp) != 1 ||
+        memcmp(tr->h.magic, TRAJECTORY_MAGIC, sizeof(TRAJECTORY_MAGIC)) != 0 ||
+        tr->h.version != TRAJECTORY_VERSION) {
+        fprintf(stderr, "openTrajectoryReader: %s is not a trajectory file\n", filename);
+        fclose(fp);
+        free(tr);
+        return NULL;
+    }
+
+    int nCoord = tr->h.n * tr->h.d;
+    tr->q      = (unsigned int *)malloc(nCoord * sizeof(unsigned int));
+    tr->q0     = (unsigned int *)malloc(nCoord * sizeof(unsigned int));
+    tr->buffer = (unsigned char *)malloc((size_t)nCoord * MAX_VARINT + (tr->h.n + 7) / 8);
+    assert(tr->q != NULL && tr->q0 != NULL && tr->buffer != NULL);
+
+    if (fread(tr->q0, sizeof(unsigned int), nCoord, fp) != (size_t)nCoord) {
+        fprintf(stderr, "openTrajectoryReader: %s is truncated\n", filename);
+        closeTrajectoryReader(tr);
+        return NULL;
+    }
+    long long start = ftello(fp);
+
+    // Use the index at the end of the file if present
+    fseeko(fp, 0, SEEK_END);
+    long long end = ftello(fp);
+    long long nFrames = -1;
+    char magic[sizeof(TRAJECTORY_INDEX_MAGIC)];
+    long long tail = sizeof(long long) + sizeof(magic);
+
+    if (end - start >= tail) {
+        fseeko(fp, end - tail, SEEK_SET);
+        if (fread(&nFrames, sizeof(long long), 1, fp) != 1 ||
+            fread(magic, 1, sizeof(magic), fp) != sizeof(magic) ||
+            memcmp(magic, TRAJECTORY_INDEX_MAGIC, sizeof(magic)) != 0 ||
+            nFrames < 0 || start + nFrames * (long long)sizeof(long long) > end - tail)
+            nFrames = -1;
+    }
+
+    if (nFrames >= 0) {
+        tr->nFrames = (long)nFrames;
+        tr->offsets = (long long *)malloc((nFrames + 1) * sizeof(long long));
+        assert(tr->offsets != NULL);
+        fseeko(fp, end - tail - nFrames * (long long)sizeof(long long), SEEK_SET);
+        if (fread(tr->offsets, sizeof(long long), nFrames, fp) != (size_t)nFrames)
+            nFrames = -1;
+    }
+
+    if (nFrames < 0) {
+        free(tr->offsets);
+        tr->nFrames = scanFrames(tr, start, end);
+    }
+
+    return tr;
+}
+
+
+// Decode one frame on top of the current reference
+static int decodeFrame(trajectoryReader *tr, long frame, long long *step) {
+
+    frameHeader fh;
+    fseeko(tr->fp, tr->offsets[frame], SEEK_SET);
+    if (fread(&fh, sizeof(frameHeader), 1, tr->fp) != 1 ||
+        fread(tr->buffer, 1, fh.size, tr->fp) != fh.size)
+        return -1;
+
+    int nCoord = tr->h.n * tr->h.d;
+    unsigned int *ref = fh.keyframe ? tr->q0 : tr->q;
+    size_t pos = 0;
+    for (int k = 0; k < nCoord; k++) {
+        unsigned int zz;
+        pos += getVarint(tr->buffer + pos, &zz);
+        tr->q[k] = decodeDelta(zz, ref[k], tr->h.bits);
+    }
+
+    tr->current = frame;
+    if (step != NULL) *step = fh.step;
+    return (int)pos;
+}
+
+
+// Read frame k: positions (n*d), states (n) and step; NULL outputs are skipped
+int readFrame(trajectoryReader *tr, long frame, double *x, int *state, long long *step) {
+
+    if (frame < 0 || frame >= tr->nFrames)
+        return -1;
+
+    // Decode forward from the nearest keyframe (or from the current frame)
+    long key = frame - frame % tr->h.keyEvery;
+    long from = (tr->current >= key && tr->current < frame) ? tr->current + 1 : key;
+
+    int pos = 0;
+    for (long f = from; f <= frame; f++) {
+        pos = decodeFrame(tr, f, step);
+        if (pos < 0) {
+            tr->current = -1;
+            return -1;
+        }
+    }
+
+    int nCoord = tr->h.n * tr->h.d;
+    if (x != NULL)
+        for (int k = 0; k < nCoord; k++)
+            x[k] = dequantize(tr->q[k], tr->h.lBox, tr->h.bits);
+
+    if (state != NULL) {
+        const unsigned char *packed = tr->buffer + pos;
+        for (int i = 0; i < tr->h.n; i++)
+            state[i] = (packed[i >> 3] >> (i & 7)) & 1;
+    }
+
+    return 0;
+}
+
+
+// Equilibrium positions x0 (n*d) at the resolution of the file
+void readEquilibrium(trajectoryReader *tr, double *x0) {
+    int nCoord = tr->h.n * tr->h.d;
+    for (int k = 0; k < nCoord; k++)
+        x0[k] = dequantize(tr->q0[k], tr->h.lBox, tr->h.bits);
+}
+
+
+// Close a trajectory reader
+void closeTrajectoryReader(trajectoryReader *tr) {
+    if (tr == NULL)
+        return;
+
+    fclose(tr->fp);
+    free(tr->q);
+    free(tr->q0);
+    free(tr->buffer);
+    free(tr->offsets);
+    free(tr);
+}
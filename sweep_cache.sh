@@ -0,0 +1,149 @@
+#!/bin/bash
+
+# =======================================================
+# Content-addressed result cache for the sweep scripts
+# =======================================================
+#
+# Sourced by full_R0_simulation.sh and full_temp_simulation.sh. Each sweep
+# point is identified by a key, the sha256 of
+#   - the engine version (contents of the program sources and headers),
+#   - the compile flags (all model parameters),
+#   - the run arguments, batch size and seed policy (batch k uses seed
+#     SEED_BASE + k).
+# Identical points of different sweeps therefore share one entry:
+#
+#   $CACHE_DIR/<key>/params       what was hashed, readable
+#   $CACHE_DIR/<key>/bin          program built for the point
+#   $CACHE_DIR/<key>/batch_K.dat  output of batch K, written atomically
+#   $CACHE_DIR/<key>/batch_K.lock claim of a batch being computed
+#
+# Completed batches are never recomputed, so an interrupted sweep resumes at
+# the first missing batch. Batches are claimed with mkdir (atomic), so any
+# number of workers, in the same script (WORKERS) or started separately,
+# can share a manifest without duplicating work. A claim left by a dead
+# process on this host is taken over.
+
+CACHE_DIR=${CACHE_DIR:-.sweep_cache}   # Cache location
+SEED_BASE=${SEED_BASE:-1}              # Seed of batch 0
+WORKERS=${WORKERS:-1}                  # Worker processes per sweep
+
+mkdir -p "$CACHE_DIR"
+
+# Files a build depends on: the sources and every header they include
+# (src/propagation_kernel.h holds the kernels), as the compiler resolves them
+# with CFLAGS; all local headers if the compiler cannot list them
+engineFiles() {
+    local deps
+    if deps=$(${GCC:-gcc} -MM $2 $1 2>/dev/null); then
+        echo "$deps" | tr -d '\\' | tr ' ' '\n' | grep -v -e ':$' -e '^$' | sort -u
+    else
+        ls $1 include/*.h src/*.h
+    fi
+}
+
+# Key of a point: cacheKey "SOURCES" "CFLAGS" "ARGS" BATCH
+cacheKey() {
+    local engine
+    engine=$(cat $(engineFiles "$1" "$2") | sha256sum | cut -d' ' -f1)
+    printf 'engine %s\ncflags %s\nargs %s\nbatch %s\nseeds %s+k\n' \
+        "$engine" "$2" "$3" "$4" "$SEED_BASE" | sha256sum | cut -d' ' -f1
+}
+
+# Register a point in a manifest: addPoint MANIFEST "SOURCES" "CFLAGS" "ARGS" BATCH NBATCHES
+# Prints the key
+addPoint() {
+    local key dir
+    key=$(cacheKey "$2" "$3" "$4" "$5")
+    dir="$CACHE_DIR/$key"
+    mkdir -p "$dir"
+    [ -f "$dir/params" ] || printf 'sources %s\ncflags %s\nargs %s\nbatch %s\nseeds %s+k\n' \
+        "$2" "$3" "$4" "$5" "$SEED_BASE" > "$dir/params"
+    printf '%s|%s|%s|%s|%s\n' "$key" "$2" "$3" "$4" "$6" >> "$1"
+    echo "$key"
+}
+
+# Claim batch K of a point: claimBatch DIR K (0 if claimed)
+claimBatch() {
+    local lock="$1/batch_$2.lock"
+    if mkdir "$lock" 2>/dev/null; then
+        echo "$BASHPID $(hostname)" > "$lock/owner"
+        return 0
+    fi
+
+    # Take over claims of dead processes on this host
+    local pid host
+    { read -r pid host < "$lock/owner"; } 2>/dev/null || return 1   # Owner not written yet, or released
+    if [ "$host" = "$(hostname)" ] && ! kill -0 "$pid" 2>/dev/null; then
+        rm -rf "$lock" "$1/batch_$2".tmp.*
+        claimBatch "$1" "$2"
+        return $?
+    fi
+    return 1
+}
+
+# Build the program of a point once (concurrent builds are harmless)
+buildPoint() {
+    local dir="$CACHE_DIR/$1"
+    [ -x "$dir/bin" ] && return 0
+    ${GCC:-gcc} $3 $2 ${LDFLAGS:--lm -lpthread} -o "$dir/bin.$BASHPID" || return 1
+    mv "$dir/bin.$BASHPID" "$dir/bin"
+}
+
+# Compute every unclaimed, missing batch of a manifest
+runWorker() {
+    local key sources cflags args nBatches dir k tmp
+    while IFS='|' read -r key sources cflags args nBatches; do
+        dir="$CACHE_DIR/$key"
+        for ((k=0; k < nBatches; k++)); do
+            [ -f "$dir/batch_$k.dat" ] && continue
+            claimBatch "$dir" "$k" || continue
+            # Finished by another worker between the check and the claim
+            if [ -f "$dir/batch_$k.dat" ]; then
+                rm -rf "$dir/batch_$k.lock"
+                continue
+            fi
+            tmp="batch_$k.tmp.$BASHPID"
+            if buildPoint "$key" "$sources" "$cflags" &&
+               (cd "$dir" && ./bin -s $((SEED_BASE + k)) $args > "$tmp"); then
+                mv "$dir/$tmp" "$dir/batch_$k.dat"
+                echo "# Cached ${key:0:12} batch $((k+1))/$nBatches"
+            else
+                rm -f "$dir/$tmp"
+                echo "# Batch $k of ${key:0:12} failed" >&2
+            fi
+            rm -rf "$dir/batch_$k.lock"
+        done
+    done < "$1"
+}
+
+# Run WORKERS workers over a manifest and wait for them
+runManifest() {
+    local w
+    for ((w=0; w < WORKERS; w++)); do
+        runWorker "$1" &
+    done
+    wait
+}
+
+# Whether the first NBATCHES batches of a point are done: pointDone KEY NBATCHES
+pointDone() {
+    local k
+    for ((k=0; k < $2; k++)); do
+        [ -f "$CACHE_DIR/$1/batch_$k.dat" ] || return 1
+    done
+}
+
+# Join the batches of a point into one file: assemblePoint KEY NBATCHES BATCH OUT
+# The header of the first batch and the trailer of the last one are kept, and
+# the realization index (first column) is renumbered as if a single run had
+# produced all of them
+assemblePoint() {
+    local dir="$CACHE_DIR/$1" k
+    pointDone "$1" "$2" || return 1
+    for ((k=0; k < $2; k++)); do
+        awk -v first=$((k == 0)) -v last=$((k == $2 - 1)) -v off=$((k * $3)) '
+            /^#/ || NF == 0 { if (data ? last : first) print; next }
+            { data = 1; $1 += off; print }' OFS='\t' "$dir/batch_$k.dat"
+    done > "$4.tmp.$BASHPID"
+    mv "$4.tmp.$BASHPID" "$4"
+}
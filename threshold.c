@@ -0,0 +1,281 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "config.h"
+#include "random.h"
+#include "system.h"
+
+// =======================================================
+//   Adaptive search of the critical sigma or lambda
+// =======================================================
+//
+// Finds the parameter value where the mean R0 (as measured by meassure,
+// minus idx0 itself) crosses a target, 1 by default, spending realizations
+// near the crossing instead of on a fixed grid. The parameter is searched on
+// a logarithmic scale inside [lo, hi]; R0 may increase or decrease with it.
+//
+//   bisect: realizations are added in batches at the midpoint until its
+//           confidence interval excludes the target (sequential test); the
+//           bracket end with the same sign is moved. Stops when the bracket
+//           is narrower than the tolerance (the bracket is the interval) or
+//           the midpoint stays undecided (its error band, through the slope
+//           of R0 over the bracket, is the interval).
+//   rm:     Robbins-Monro iteration u <- u - a_n (mean R0 - target) on
+//           u = log(parameter), one batch per step, gain a_n = n^-0.75 / |slope|
+//           and Polyak averaging of the iterates after a burn-in. The
+//           interval uses the slope of R0 in u fitted over the batches.
+//
+// Only the chosen parameter changes at runtime; the others are compiled in
+// as in the other programs.
+
+// Parameters the search can act on
+enum { PARAM_SIGMA, PARAM_LAMBDA };
+
+typedef struct {
+    systemSI *pS;
+    int param;              // PARAM_*
+    double sigma, lambda;   // Current values
+    double beta;
+    long maxSteps;          // Step limit of one realization
+    long realizations;      // Realizations run so far
+} searchState;
+
+// Running mean and variance of R0 at one parameter value
+typedef struct {
+    long n;
+    double sum, sumSq;
+} r0Samples;
+
+
+// Set the searched parameter (sigma regroups the particles; the positions
+// are redrawn by resetSystem before each realization)
+static void setParameter(searchState *st, double value) {
+    if (st->param == PARAM_SIGMA) {
+        st->sigma = value;
+        uniformSigma(st->pS, value);
+    } else {
+        st->lambda = value;
+    }
+}
+
+
+// Add one batch of realizations at the current parameter value
+static void sampleBatch(searchState *st, r0Samples *s, int batch, double target) {
+    for (int k = 0; k < batch; k++) {
+        resetSystem(st->pS);
+        double r0 = measureR0(st->pS, st->beta, st->lambda, st->maxSteps, NULL) - 1;
+        s->n++;
+        s->sum += r0 - target;
+        s->sumSq += (r0 - target) * (r0 - target);
+    }
+    st->realizations += batch;
+}
+
+
+static double sampleMean(const r0Samples *s) {
+    return s->sum / s->n;
+}
+
+
+// Standard error of the mean
+static double sampleError(const r0Samples *s) {
+    if (s->n < 2) return INFINITY;
+    double mean = s->sum / s->n;
+    double var = (s->sumSq - s->n * mean * mean) / (s->n - 1);
+    return sqrt((var > 0.0 ? var : 0.0) / s->n);
+}
+
+
+// Sample at a value until the sign of R0 - target is significant (returns
+// +1 or -1), or 0 if maxPerPoint realizations do not decide it
+static int decideSign(searchState *st, double value, int batch, long maxPerPoint,
+                      double target, double z, r0Samples *s) {
+    setParameter(st, value);
+    *s = (r0Samples){0, 0.0, 0.0};
+
+    while (s->n < maxPerPoint) {
+        sampleBatch(st, s, batch, target);
+        double mean = sampleMean(s);
+        if (fabs(mean) > z * sampleError(s)) return (mean > 0.0) ? 1 : -1;
+    }
+    return 0;
+}
+
+
+static void printPoint(const char *what, double value, const r0Samples *s, double target, int sign) {
+    printf("%s\t%.6g\t%ld\t%.4f\t%.4f\t%+d\n", what, value, s->n,
+           sampleMean(s) + target, sampleError(s), sign);
+    fflush(stdout);
+}
+
+
+int main(int argc, char **argv) {
+
+    // Command-line options
+    const char *paramName = "sigma";     // -p: sigma or lambda
+    const char *method = "bisect";       // -a: bisect or rm
+    double lo = 0.1, hi = 33.0;          // -l, -h: search bracket
+    double target = 1.0;                 // -t: target R0
+    int batch = 50;                      // -b: realizations per batch
+    long budget = 20000;                 // -n: realizations per point (bisect) or in total (rm)
+    double tol = 0.02;                   // -e: relative bracket width (bisect)
+    long maxSteps = 10000;               // -m: steps per realization
+    double z = 1.96;                     // -z: confidence (normal quantile)
+    unsigned int seed = 0;               // -s: random seed (0 uses time)
+
+    int opt;
+    while ((opt = getopt(argc, argv, "p:a:l:h:t:b:n:e:m:z:s:")) != -1) {
+        switch (opt) {
+            case 'p': paramName = optarg; break;
+            case 'a': method = optarg; break;
+            case 'l': lo = atof(optarg); break;
+            case 'h': hi = atof(optarg); break;
+            case 't': target = atof(optarg); break;
+            case 'b': batch = atoi(optarg); break;
+            case 'n': budget = atol(optarg); break;
+            case 'e': tol = atof(optarg); break;
+            case 'm': maxSteps = atol(optarg); break;
+            case 'z': z = atof(optarg); break;
+            case 's': seed = (unsigned int)strtoul(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "Usage: %s [-p sigma|lambda] [-a bisect|rm] [-l lo] [-h hi] [-t target] "
+                                "[-b batch] [-n budget] [-e tol] [-m steps] [-z quantile] [-s seed]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    int param;
+    if (strcmp(paramName, "sigma") == 0) param = PARAM_SIGMA;
+    else if (strcmp(paramName, "lambda") == 0) param = PARAM_LAMBDA;
+    else {
+        fprintf(stderr, "Unknown parameter %s (sigma or lambda)\n", paramName);
+        return 1;
+    }
+    if (strcmp(method, "bisect") != 0 && strcmp(method, "rm") != 0) {
+        fprintf(stderr, "Unknown method %s (bisect or rm)\n", method);
+        return 1;
+    }
+    if (!(lo > 0.0 && hi > lo) || batch < 2) {
+        fprintf(stderr, "Need 0 < lo < hi and batch >= 2\n");
+        return 1;
+    }
+
+    // Initialize random seed
+    seed_random(seed);
+
+    searchState st = {NULL, param, SIGMA, LAMBDA, BETA, maxSteps, 0};
+    st.pS = makeSystem(RC, DT, ALPHA, SIGMA, DIM, COORDINATION);
+
+    printf("# Threshold search: R0(%s) = %g, %s in [%g, %g]\n", paramName, target, method, lo, hi);
+    printf("# N=%d PHI=%g RC=%g ALPHA=%g SIGMA=%g DT=%g BETA=%g LAMBDA=%g\n",
+           N, PHI, RC, ALPHA, SIGMA, DT, BETA, LAMBDA);
+    printf("# Point\tValue\tRealiz\tR0\tStdErr\tSign\n");
+
+    // Both ends must be on opposite sides of the target
+    r0Samples sLo, sHi;
+    int signLo = decideSign(&st, lo, batch, budget, target, z, &sLo);
+    printPoint("lo", lo, &sLo, target, signLo);
+    int signHi = decideSign(&st, hi, batch, budget, target, z, &sHi);
+    printPoint("hi", hi, &sHi, target, signHi);
+
+    if (signLo == 0 || signHi == 0 || signLo == signHi) {
+        fprintf(stderr, "threshold: no significant crossing of %g in [%g, %g]\n", target, lo, hi);
+        destroySystem(st.pS);
+        return 1;
+    }
+
+    double uLo = log(lo), uHi = log(hi);
+    double estimate, ciLo, ciHi;
+
+    if (strcmp(method, "bisect") == 0) {
+        double uMid = uLo;
+        r0Samples sMid = {0, 0.0, 0.0};
+        int sign = signLo;
+        while (uHi - uLo > log1p(tol)) {
+            uMid = 0.5 * (uLo + uHi);
+            sign = decideSign(&st, exp(uMid), batch, budget, target, z, &sMid);
+            printPoint("mid", exp(uMid), &sMid, target, sign);
+
+            // Within noise of the crossing at this budget
+            if (sign == 0) break;
+            if (sign == signLo) {
+                uLo = uMid;
+                sLo = sMid;
+            } else {
+                uHi = uMid;
+                sHi = sMid;
+            }
+        }
+
+        // Secant of R0 in u over the final bracket
+        double fLo = sampleMean(&sLo), fHi = sampleMean(&sHi);
+        double slope = (fHi - fLo) / (uHi - uLo);
+
+        if (sign == 0) {
+            // Undecided midpoint: its error band mapped through the slope
+            double uErr = z * sampleError(&sMid) / fabs(slope);
+            double uStar = uMid - sampleMean(&sMid) / slope;
+            estimate = exp(uStar);
+            ciLo = exp(fmax(uStar - uErr, uLo));
+            ciHi = exp(fmin(uStar + uErr, uHi));
+            printf("# Midpoint undecided after %ld realizations\n", budget);
+        } else {
+            // Each bracket end is significant on its side of the target
+            estimate = exp(uLo - fLo / slope);
+            ciLo = exp(uLo);
+            ciHi = exp(uHi);
+        }
+    } else {
+        // Gain from the secant slope of R0 in u over the bracket
+        double slope = (sampleMean(&sHi) - sampleMean(&sLo)) / (uHi - uLo);
+        double u = 0.5 * (uLo + uHi);
+        long nBatches = budget / batch;
+        long burnIn = nBatches / 4;
+
+        // Polyak average of the iterates, and a fit of R0 against u
+        double uSum = 0.0, varSum = 0.0;
+        double su = 0.0, sf = 0.0, suu = 0.0, suf = 0.0;
+        long nAvg = 0;
+
+        for (long k = 1; k <= nBatches; k++) {
+            r0Samples s = {0, 0.0, 0.0};
+            setParameter(&st, exp(u));
+            sampleBatch(&st, &s, batch, target);
+            double f = sampleMean(&s);
+            printPoint("rm", exp(u), &s, target, 0);
+
+            su += u; sf += f; suu += u * u; suf += u * f;
+
+            if (k > burnIn) {
+                uSum += u;
+                varSum += sampleError(&s) * sampleError(&s) * batch;
+                nAvg++;
+            }
+
+            u -= pow((double)k, -0.75) * f / slope;
+            if (u < uLo) u = uLo;
+            if (u > uHi) u = uHi;
+        }
+
+        // Refit the slope near the crossing for the interval
+        double denom = nBatches * suu - su * su;
+        if (denom > 0.0) {
+            double fit = (nBatches * suf - su * sf) / denom;
+            if (fit * slope > 0.0) slope = fit;
+        }
+
+        // Var(u) ~ Var(R0) / (slope^2 * realizations averaged)
+        double uBar = uSum / nAvg;
+        double uErr = sqrt(varSum / nAvg / (nAvg * batch)) / fabs(slope);
+        estimate = exp(uBar);
+        ciLo = exp(uBar - z * uErr);
+        ciHi = exp(uBar + z * uErr);
+    }
+
+    printf("# Critical %s\tLow\tHigh\tRealizations\n", paramName);
+    printf("%.6g\t%.6g\t%.6g\t%ld\n", estimate, ciLo, ciHi, st.realizations);
+
+    destroySystem(st.pS);
+
+    return 0;
+}
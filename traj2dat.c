@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "config.h"
+#include "trajectory.h"
+
+// Convert frames of a compressed trajectory file to text
+//   ./traj2dat FILE          list frames (frame, step, time)
+//   ./traj2dat FILE K        print frame K: index, x, y, state
+//   ./traj2dat FILE x0       print equilibrium positions: index, x0, y0
+int main(int argc, char **argv) {
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s FILE [frame|x0]\n", argv[0]);
+        return 1;
+    }
+
+    trajectoryReader *tr = openTrajectoryReader(argv[1]);
+    if (tr == NULL) return 1;
+
+    int n = tr->h.n;
+    int d = tr->h.d;
+
+    printf("# N=%d d=%d L=%.6f dt=%g bits=%d keyframe=%d frames=%ld\n",
+           n, d, tr->h.lBox, tr->h.dt, tr->h.bits, tr->h.keyEvery, tr->nFrames);
+
+    double *x = (double *)malloc(n * d * sizeof(double));
+    int *state = (int *)malloc(n * sizeof(int));
+    assert(x != NULL && state != NULL);
+
+    int status = 0;
+    if (argc < 3) {
+        // List frames
+        printf("# Frame\tStep\tTime\n");
+        for (long f = 0; f < tr->nFrames; f++) {
+            long long step;
+            if (readFrame(tr, f, NULL, NULL, &step) != 0) { status = 1; break; }
+            printf("%ld\t%lld\t%.4f\n", f, step, step * tr->h.dt);
+        }
+    } else if (strcmp(argv[2], "x0") == 0) {
+        readEquilibrium(tr, x);
+        printf("# Index\tx0\ty0\n");
+        for (int i = 0; i < n; i++)
+            printf("%d\t%.6f\t%.6f\n", i, x[d * i + 0], x[d * i + 1]);
+    } else {
+        long frame = atol(argv[2]);
+        long long step;
+        if (readFrame(tr, frame, x, state, &step) != 0) {
+            fprintf(stderr, "Cannot read frame %ld\n", frame);
+            status = 1;
+        } else {
+            printf("# Frame %ld, step %lld, time %.4f\n", frame, step, step * tr->h.dt);
+            printf("# Index\tx\ty\tstate\n");
+            for (int i = 0; i < n; i++)
+                printf("%d\t%.6f\t%.6f\t%d\n", i, x[d * i + 0], x[d * i + 1], state[i]);
+        }
+    }
+
+    free(x);
+    free(state);
+    closeTrajectoryReader(tr);
+
+    return status;
+}
@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "config.h"
+#include "random.h"
+#include "system.h"
+#include "stats.h"
+
+// =======================================================
+//   Statistical equivalence of propagation kernels
+// =======================================================
+//
+// Runs a reference and a candidate kernel for many independent seeds on a
+// small system and compares the distributions of
+//   - I(t) at four fixed times (KS test)
+//   - the extinction time (KS test, censored at the last step)
+//   - R0, for kernels that track ever-infected particles (chi-square test)
+// Each test passes if its p-value exceeds the significance level divided by
+// the number of tests (Bonferroni). Exit status is 0 on PASS, 1 on FAIL.
+//
+// The candidate samples can be saved (-w) and used later as the reference
+// (-x) of another build, e.g. to compare the single and double precision
+// modes (run_precision_check.sh).
+
+// Largest R0 value binned separately in the chi-square test
+#define MAX_R0_BIN 64
+
+// Number of fixed times at which I(t) is compared
+#define N_TIMES 4
+
+// Samples of one kernel over all seeds
+typedef struct {
+    double *infected[N_TIMES];  // I(t) at the fixed times
+    double *extinction;         // Extinction time (censored at the last step)
+    double *r0;                 // Secondary infections of idx0
+} samples;
+
+
+static void freeSamples(samples *s);
+
+
+static void allocSamples(samples *s, int nSeeds) {
+    for (int t = 0; t < N_TIMES; t++) {
+        s->infected[t] = (double *)malloc(nSeeds * sizeof(double));
+        assert(s->infected[t] != NULL);
+    }
+    s->extinction = (double *)malloc(nSeeds * sizeof(double));
+    s->r0 = (double *)malloc(nSeeds * sizeof(double));
+    assert(s->extinction != NULL && s->r0 != NULL);
+}
+
+
+// Write samples as text: one line per seed with I(t), extinction and R0
+static int writeSamples(const char *filename, const samples *s, int nSeeds) {
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL) {
+        fprintf(stderr, "writeSamples: cannot open %s\n", filename);
+        return -1;
+    }
+    fprintf(fp, "# %d seeds: I(t) at %d times, extinction, R0 (sizeof(real)=%d)\n",
+            nSeeds, N_TIMES, (int)sizeof(real));
+    for (int k = 0; k < nSeeds; k++) {
+        for (int t = 0; t < N_TIMES; t++) fprintf(fp, "%.17g\t", s->infected[t][k]);
+        fprintf(fp, "%.17g\t%.17g\n", s->extinction[k], s->r0[k]);
+    }
+    fclose(fp);
+    return 0;
+}
+
+
+// Read samples written by writeSamples; returns the number of seeds or -1
+static int readSamples(const char *filename, samples *s) {
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "readSamples: cannot open %s\n", filename);
+        return -1;
+    }
+
+    int nSeeds;
+    if (fscanf(fp, "# %d seeds%*[^\n]", &nSeeds) != 1 || nSeeds <= 0) {
+        fprintf(stderr, "readSamples: %s: bad header\n", filename);
+        fclose(fp);
+        return -1;
+    }
+
+    allocSamples(s, nSeeds);
+    for (int k = 0; k < nSeeds; k++) {
+        int ok = 1;
+        for (int t = 0; t < N_TIMES; t++) ok &= (fscanf(fp, "%lf", &s->infected[t][k]) == 1);
+        ok &= (fscanf(fp, "%lf %lf", &s->extinction[k], &s->r0[k]) == 2);
+        if (!ok) {
+            fprintf(stderr, "readSamples: %s: truncated at seed %d\n", filename, k);
+            freeSamples(s);
+            fclose(fp);
+            return -1;
+        }
+    }
+    fclose(fp);
+    return nSeeds;
+}
+
+
+static void freeSamples(samples *s) {
+    for (int t = 0; t < N_TIMES; t++) free(s->infected[t]);
+    free(s->extinction);
+    free(s->r0);
+}
+
+
+static int countInfected(systemSI *pS) {
+    int nI = 0;
+    for (int i = 0; i < N; i++) nI += (pS->state[i] == 0);
+    return nI;
+}
+
+
+// Run one realization on a reset system and store its observables at position k
+static void runRealization(systemSI *pS, const kernelInfo *e, unsigned int seed, long nSteps,
+                           double beta, double lambda, samples *s, int k) {
+
+    seed_random(seed);
+    resetSystem(pS);
+
+    long times[N_TIMES];
+    for (int t = 0; t < N_TIMES; t++) times[t] = nSteps >> (N_TIMES - 1 - t);
+
+    int idx0 = pS->idx0;
+    int r0Done = 0;
+    int nI = countInfected(pS);
+    long step = 0;
+    int t = 0;
+    s->r0[k] = 0.0;
+
+    while (step < nSteps && nI > 0) {
+        iteration(pS);
+        e->run(pS, beta, lambda);
+        step++;
+        nI = countInfected(pS);
+
+        while (t < N_TIMES && times[t] == step) s->infected[t++][k] = nI;
+
+        // R0: infections caused by idx0 until its first recovery
+        if (e->tracksFlag && !r0Done && pS->state[idx0] != 0) {
+            int nFlag = 0;
+            for (int i = 0; i < N; i++) nFlag += pS->flag[i];
+            s->r0[k] = nFlag - 1;
+            r0Done = 1;
+        }
+    }
+
+    // Extinct before the remaining sampling times
+    while (t < N_TIMES) s->infected[t++][k] = 0.0;
+    s->extinction[k] = step;
+}
+
+
+// Bin R0 samples for the chi-square test
+static void binR0(const double *r0, int n, double *bins) {
+    for (int b = 0; b <= MAX_R0_BIN; b++) bins[b] = 0.0;
+    for (int i = 0; i < n; i++) {
+        int b = (int)r0[i];
+        if (b > MAX_R0_BIN) b = MAX_R0_BIN;
+        if (b < 0) b = 0;
+        bins[b] += 1.0;
+    }
+}
+
+
+int main(int argc, char **argv) {
+
+    // Command-line options
+    const char *refName = "v02";         // -r: reference kernel
+    const char *candName = "v02";        // -c: candidate kernel
+    int nSeeds = 400;                    // -n: realizations per kernel
+    long nSteps = 1000;                  // -m: maximum steps per realization
+    double beta = BETA;                  // -b: recovery rate
+    double lambda = LAMBDA;              // -l: spatial decay of infection
+    double significance = 0.01;          // -a: overall significance level
+    unsigned int seed = 1;               // -s: first seed
+    const char *writeFile = NULL;        // -w: save the candidate samples
+    const char *refFile = NULL;          // -x: reference samples from a file
+
+    int opt;
+    while ((opt = getopt(argc, argv, "r:c:n:m:b:l:a:s:w:x:")) != -1) {
+        switch (opt) {
+            case 'r': refName = optarg; break;
+            case 'c': candName = optarg; break;
+            case 'n': nSeeds = atoi(optarg); break;
+            case 'm': nSteps = atol(optarg); break;
+            case 'b': beta = atof(optarg); break;
+            case 'l': lambda = atof(optarg); break;
+            case 'a': significance = atof(optarg); break;
+            case 's': seed = (unsigned int)strtoul(optarg, NULL, 10); break;
+            case 'w': writeFile = optarg; break;
+            case 'x': refFile = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-r ref] [-c candidate] [-n seeds] [-m steps] "
+                                "[-b beta] [-l lambda] [-a significance] [-s seed] "
+                                "[-w samples] [-x refSamples]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    const kernelInfo *ref = findKernel(refName);
+    const kernelInfo *cand = findKernel(candName);
+    if (ref == NULL || cand == NULL) {
+        fprintf(stderr, "Unknown kernel: %s\n", ref == NULL ? refName : candName);
+        return 2;
+    }
+
+    if (refFile != NULL) printf("# Reference %s (from %s) vs candidate %s\n", ref->name, refFile, cand->name);
+    else                 printf("# Reference %s vs candidate %s\n", ref->name, cand->name);
+    printf("# N=%d PHI=%g RC=%g ALPHA=%g SIGMA=%g DT=%g beta=%g lambda=%g\n",
+           N, (double)PHI, (double)RC, (double)ALPHA, (double)SIGMA, (double)DT, beta, lambda);
+    printf("# %d seeds per kernel, %ld steps max, sizeof(real)=%d\n", nSeeds, nSteps, (int)sizeof(real));
+
+    // One system reused for every realization
+    systemSI *pS = makeSystem(RC, DT, ALPHA, SIGMA, DIM, COORDINATION);
+
+    // Independent seeds for the two kernels
+    samples sRef, sCand;
+    int nRef = nSeeds;
+    if (refFile != NULL) {
+        nRef = readSamples(refFile, &sRef);
+        if (nRef < 0) return 2;
+    } else {
+        allocSamples(&sRef, nSeeds);
+    }
+    allocSamples(&sCand, nSeeds);
+    for (int k = 0; k < nSeeds; k++) {
+        if (refFile == NULL) runRealization(pS, ref, seed + k, nSteps, beta, lambda, &sRef, k);
+        runRealization(pS, cand, seed + nSeeds + k, nSteps, beta, lambda, &sCand, k);
+    }
+
+    destroySystem(pS);
+
+    if (writeFile != NULL && writeSamples(writeFile, &sCand, nSeeds) != 0) return 2;
+
+    int compareR0 = ref->tracksFlag && cand->tracksFlag;
+    int nTests = N_TIMES + 1 + compareR0;
+    double threshold = significance / nTests;
+    int failed = 0;
+
+    printf("# Observable\tTest\tStatistic\tp-value\tResult (p > %.2e)\n", threshold);
+
+    for (int t = 0; t < N_TIMES; t++) {
+        double d;
+        long time = nSteps >> (N_TIMES - 1 - t);
+        double p = ksTwoSample(sRef.infected[t], nRef, sCand.infected[t], nSeeds, &d);
+        failed += (p <= threshold);
+        printf("I(t=%.2f)\tKS\tD=%.4f\t%.4e\t%s\n", time * DT, d, p, p > threshold ? "PASS" : "FAIL");
+    }
+
+    double d;
+    double p = ksTwoSample(sRef.extinction, nRef, sCand.extinction, nSeeds, &d);
+    failed += (p <= threshold);
+    printf("extinction\tKS\tD=%.4f\t%.4e\t%s\n", d, p, p > threshold ? "PASS" : "FAIL");
+
+    if (compareR0) {
+        double binsRef[MAX_R0_BIN + 1], binsCand[MAX_R0_BIN + 1], chsq;
+        int df;
+        binR0(sRef.r0, nRef, binsRef);
+        binR0(sCand.r0, nSeeds, binsCand);
+        p = chiSquareTwoSample(binsRef, binsCand, MAX_R0_BIN + 1, &chsq, &df);
+        failed += (p <= threshold);
+        printf("R0\t\tchi2\t%.3f/%d\t%.4e\t%s\n", chsq, df, p, p > threshold ? "PASS" : "FAIL");
+    }
+
+    printf("# RESULT: %s (%d of %d tests failed)\n", failed ? "FAIL" : "PASS", failed, nTests);
+
+    freeSamples(&sRef);
+    freeSamples(&sCand);
+
+    return failed ? 1 : 0;
+}